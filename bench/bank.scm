@@ -0,0 +1,31 @@
+; Closure-heavy bank accounts, after test84.scm: each account is a closure
+; over its own balance, updated with set!, sharing a withdrawal limit.
+(define make-account
+  (let ((max-withdrawal 10))
+    (lambda (balance)
+      (lambda (amt)
+        (begin (if (< amt max-withdrawal)
+                   (set! balance (- balance amt))
+                   (set! max-withdrawal (+ max-withdrawal 1)))
+               balance)))))
+
+(define make-accounts
+  (lambda (n)
+    (if (= n 0)
+        (quote ())
+        (cons (make-account (* n 100)) (make-accounts (- n 1))))))
+
+(define touch-all
+  (lambda (accounts amt total)
+    (if (null? accounts)
+        total
+        (touch-all (cdr accounts) amt (+ total ((car accounts) amt))))))
+
+(define run
+  (lambda (accounts rounds total)
+    (if (= rounds 0)
+        total
+        (run accounts (- rounds 1)
+             (touch-all accounts (modulo rounds 13) total)))))
+
+(run (make-accounts 400) 500 0)
@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+'''Times the interpreter on the Scheme workloads in this directory.
+
+Each benchmark is run several times, and the best and median wall time, the
+peak resident set size and the number of objects allocated on the collected
+heap are reported. A benchmark with a matching .output file also has its
+output checked, so a broken build does not go unnoticed behind good numbers.
+
+    ./bench/bench.py [--runs N] [--vm] [--interpreter PATH] [NAME ...]
+'''
+
+import argparse
+import collections
+import os
+import re
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                '..'))
+import tester
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+
+class BenchmarkError(Exception):
+    '''A benchmark that crashed, or gave the wrong output.'''
+
+
+Run = collections.namedtuple('Run', ['seconds', 'max_rss_kb', 'objects',
+                                     'output'])
+
+
+def find_benchmarks(names=None):
+    '''Returns the paths of the .scm files in BENCH_DIR, or just the named
+    ones.'''
+    found = sorted(name[:-4] for name in os.listdir(BENCH_DIR)
+                   if name.endswith('.scm'))
+    if names:
+        missing = [name for name in names if name not in found]
+        if missing:
+            sys.exit('No such benchmark: ' + ', '.join(missing))
+        found = [name for name in found if name in names]
+    return [os.path.join(BENCH_DIR, name + '.scm') for name in found]
+
+
+def run_once(command, path) -> Run:
+    '''Runs the interpreter on one program, and measures it. The allocation
+    count and peak RSS come from what --gc-stats prints on stderr.'''
+    with open(path, 'r') as program, \
+            tempfile.TemporaryFile() as output, \
+            tempfile.TemporaryFile() as errors:
+        start = time.perf_counter()
+        process = subprocess.Popen(command, stdin=program, stdout=output,
+                                   stderr=errors)
+        process.wait()
+        seconds = time.perf_counter() - start
+
+        output.seek(0)
+        errors.seek(0)
+        stats = errors.read().decode('utf-8')
+        objects = re.search(r'gc: (\d+) objects', stats)
+        peak = re.search(r'memory: (\d+) kB', stats)
+        if process.returncode != 0 or objects is None:
+            raise BenchmarkError('{} failed:\n{}'.format(
+                os.path.basename(path), stats))
+        return Run(seconds, int(peak.group(1)) if peak else 0,
+                   int(objects.group(1)), output.read().decode('utf-8'))
+
+
+def check_output(path, output) -> bool:
+    '''Compares output with the benchmark's .output file the way tester.py
+    compares test output. Benchmarks without one always pass.'''
+    expected_path = path[:-4] + '.output'
+    if not os.path.exists(expected_path):
+        return True
+    expected = tester.get_correct_output(expected_path)
+    return tester.clean_output(output) == tester.clean_output(expected)
+
+
+def measure(command, path, runs, warmup=0):
+    '''Runs a benchmark warmup + runs times and returns the measured runs.
+    Raises BenchmarkError if its output is wrong.'''
+    results = []
+    for i in range(warmup + runs):
+        run = run_once(command, path)
+        if i == 0 and not check_output(path, run.output):
+            raise BenchmarkError('{} gave the wrong output:\n{}'.format(
+                os.path.basename(path), run.output))
+        if i >= warmup:
+            results.append(run)
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--runs', type=int, default=5,
+                        help='times to run each benchmark (default 5)')
+    parser.add_argument('--vm', action='store_true',
+                        help='run on the bytecode VM instead of eval')
+    parser.add_argument('--interpreter', default='./interpreter',
+                        help='interpreter to time (default ./interpreter)')
+    parser.add_argument('names', nargs='*',
+                        help='benchmarks to run (default all)')
+    args = parser.parse_args()
+
+    command = [os.path.abspath(args.interpreter), '--gc-stats']
+    if args.vm:
+        command.append('--vm')
+
+    print('{:<12} {:>10} {:>10} {:>10} {:>12}'.format(
+        'benchmark', 'best ms', 'median ms', 'peak KB', 'objects'))
+    for path in find_benchmarks(args.names):
+        try:
+            results = measure(command, path, args.runs)
+        except BenchmarkError as error:
+            sys.exit(str(error))
+        times = [run.seconds * 1000 for run in results]
+        print('{:<12} {:>10.1f} {:>10.1f} {:>10} {:>12}'.format(
+            os.path.basename(path)[:-4], min(times), statistics.median(times),
+            max(run.max_rss_kb for run in results), results[0].objects))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+'''Records benchmark numbers as a baseline, and checks new builds against it.
+
+    ./bench/gate.py record [options]   measure and write the baseline
+    ./bench/gate.py check [options]    measure and compare with the baseline
+
+The corpus is the workloads in bench/ plus every test in test-files-e and
+test-files-m that runs without an error, found the same way tester.py finds
+them. For each program the baseline keeps the median wall time, the peak RSS
+and the number of heap objects allocated. check exits with status 1 if any of
+them has grown by more than the threshold, or if a program in the baseline
+now crashes, stops with an error or gives the wrong output.
+
+Allocation counts are exact, so they catch regressions in programs far too
+short to time. Times and peak RSS are noisy, so check also ignores growth
+smaller than --min-ms and --min-kb. To keep noise down further, every program
+is run --warmup times before it is measured, and everything runs pinned to
+one CPU.
+The baseline is specific to the machine it was recorded on.
+'''
+
+import argparse
+import json
+import os
+import statistics
+import sys
+
+import bench
+import tester
+
+REPO_DIR = os.path.dirname(bench.BENCH_DIR)
+TEST_DIRS = ['test-files-e', 'test-files-m']
+METRICS = ['median_ms', 'peak_kb', 'objects']
+
+
+def find_corpus(vm):
+    '''Returns (name, path) for every program in the corpus.'''
+    corpus = [('bench/' + os.path.basename(path)[:-4], path)
+              for path in bench.find_benchmarks()]
+    for test_dir in TEST_DIRS:
+        for test_name in tester.find_tests(os.path.join(REPO_DIR, test_dir),
+                                           vm):
+            corpus.append((test_dir + '/' + test_name,
+                           os.path.join(REPO_DIR, test_dir,
+                                        test_name + '.scm')))
+    return corpus
+
+
+def measure_corpus(command, runs, warmup, vm):
+    '''Returns the baseline entries for the corpus, and the error for each
+    program that crashed, stopped with an error or gave the wrong output.'''
+    results = {}
+    failures = {}
+    for name, path in find_corpus(vm):
+        try:
+            measured = bench.measure(command, path, runs, warmup)
+        except bench.BenchmarkError as error:
+            failures[name] = str(error)
+            continue
+        results[name] = {
+            'median_ms': statistics.median(run.seconds * 1000
+                                           for run in measured),
+            'peak_kb': max(run.max_rss_kb for run in measured),
+            'objects': measured[0].objects,
+        }
+    return results, failures
+
+
+def regressions(baseline, current, threshold, slack):
+    '''Returns (name, metric, old, new) for each number that got worse by
+    more than threshold percent, and by more than slack[metric]. Programs
+    missing from either side are the caller's to report.'''
+    found = []
+    for name in sorted(set(baseline) & set(current)):
+        for metric in METRICS:
+            old = baseline[name][metric]
+            new = current[name][metric]
+            if new <= old * (1 + threshold / 100):
+                continue
+            if new - old <= slack.get(metric, 0):
+                continue
+            found.append((name, metric, old, new))
+    return found
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('action', choices=['record', 'check'])
+    parser.add_argument('--baseline',
+                        default=os.path.join(bench.BENCH_DIR, 'baseline.json'),
+                        help='baseline file (default bench/baseline.json)')
+    parser.add_argument('--runs', type=int, default=5,
+                        help='measured runs per program (default 5)')
+    parser.add_argument('--warmup', type=int, default=1,
+                        help='unmeasured runs first (default 1)')
+    parser.add_argument('--threshold', type=float, default=10,
+                        help='percent growth that fails check (default 10)')
+    parser.add_argument('--min-ms', type=float, default=5,
+                        help='time growth always tolerated (default 5)')
+    parser.add_argument('--min-kb', type=float, default=512,
+                        help='peak RSS growth always tolerated (default 512)')
+    parser.add_argument('--cpu', type=int, default=0,
+                        help='CPU to pin to, or -1 not to pin (default 0)')
+    parser.add_argument('--vm', action='store_true',
+                        help='run on the bytecode VM instead of eval')
+    parser.add_argument('--interpreter',
+                        default=os.path.join(REPO_DIR, 'interpreter'),
+                        help='interpreter to measure')
+    args = parser.parse_args()
+
+    if args.cpu >= 0 and hasattr(os, 'sched_setaffinity'):
+        os.sched_setaffinity(0, {args.cpu})
+
+    command = [os.path.abspath(args.interpreter), '--gc-stats']
+    if args.vm:
+        command.append('--vm')
+    current, failures = measure_corpus(command, args.runs, args.warmup,
+                                      args.vm)
+
+    if args.action == 'record':
+        # Tests that stop with an error print no statistics, so they are left
+        # out of the baseline. The workloads must all run.
+        for name in failures:
+            if name.startswith('bench/'):
+                sys.exit(failures[name])
+        with open(args.baseline, 'w') as baseline_file:
+            json.dump(current, baseline_file, indent=2, sort_keys=True)
+        print('Recorded {} programs in {}'.format(len(current), args.baseline))
+        return 0
+
+    if not os.path.exists(args.baseline):
+        sys.exit('No baseline at {}; run record first'.format(args.baseline))
+    with open(args.baseline, 'r') as baseline_file:
+        baseline = json.load(baseline_file)
+    # A program in the baseline that no longer runs correctly is a failure in
+    # itself, not something to skip.
+    broken = sorted(name for name in baseline if name not in current)
+    for name in broken:
+        print('{:<24} {}'.format(
+            name, failures.get(name, 'missing from the corpus').splitlines()[0]))
+    found = regressions(baseline, current, args.threshold,
+                        {'median_ms': args.min_ms, 'peak_kb': args.min_kb})
+    for name, metric, old, new in found:
+        print('{:<24} {:<10} {:>12.1f} -> {:>12.1f}  (+{:.1f}%)'.format(
+            name, metric, old, new, (new / old - 1) * 100 if old else 100))
+    if broken:
+        print('{} programs in the baseline failed'.format(len(broken)))
+    if found:
+        print('{} regressions beyond {}%'.format(len(found), args.threshold))
+    if broken or found:
+        return 1
+    print('No regressions in {} programs'.format(len(current)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,28 @@
+; Builds long lists, reverses them and sums them: cons allocation and
+; traversal, with plenty for the collector to do.
+(define iota
+  (lambda (n acc)
+    (if (= n 0)
+        acc
+        (iota (- n 1) (cons n acc)))))
+
+(define reverse-onto
+  (lambda (list acc)
+    (if (null? list)
+        acc
+        (reverse-onto (cdr list) (cons (car list) acc)))))
+
+(define sum
+  (lambda (list acc)
+    (if (null? list)
+        acc
+        (sum (cdr list) (+ acc (car list))))))
+
+(define repeat
+  (lambda (times total)
+    (if (= times 0)
+        total
+        (repeat (- times 1)
+                (+ total (sum (reverse-onto (iota 10000 (quote ())) (quote ())) 0))))))
+
+(repeat 20 0)
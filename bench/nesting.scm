@@ -0,0 +1,23 @@
+; Deeply nested let* and letrec forms inside a loop: frame creation and
+; variable lookup through several levels of environment.
+(define step
+  (lambda (x)
+    (let* ((a (+ x 1))
+           (b (+ a 1))
+           (c (+ b a)))
+      (letrec ((even? (lambda (n) (if (= n 0) #t (odd? (- n 1)))))
+               (odd? (lambda (n) (if (= n 0) #f (even? (- n 1))))))
+        (let* ((d (if (even? (modulo c 16)) c (- c 1)))
+               (e (let ((f (* d 2)))
+                    (let* ((g (- f a)) (h (+ g b)))
+                      (let ((i (- h c)))
+                        (+ i d))))))
+          (modulo e 1000))))))
+
+(define loop
+  (lambda (n acc)
+    (if (= n 0)
+        acc
+        (loop (- n 1) (+ acc (step (+ n acc)))))))
+
+(loop 30000 0)
@@ -0,0 +1,30 @@
+; Counts the solutions to the eight queens problem by backtracking over
+; lists of the queens placed so far.
+(define safe?
+  (lambda (row distance placed)
+    (cond ((null? placed) #t)
+          ((= (car placed) row) #f)
+          ((= (car placed) (+ row distance)) #f)
+          ((= (car placed) (- row distance)) #f)
+          (else (safe? row (+ distance 1) (cdr placed))))))
+
+(define try-rows
+  (lambda (row n placed)
+    (if (> row n)
+        0
+        (+ (if (safe? row 1 placed)
+               (queens n (cons row placed))
+               0)
+           (try-rows (+ row 1) n placed)))))
+
+(define length-of
+  (lambda (list)
+    (if (null? list) 0 (+ 1 (length-of (cdr list))))))
+
+(define queens
+  (lambda (n placed)
+    (if (= (length-of placed) n)
+        1
+        (try-rows 1 n placed))))
+
+(queens 8 (quote ()))
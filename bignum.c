@@ -0,0 +1,584 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "bignum.h"
+#include "value.h"
+#include "gc.h"
+#include "talloc.h"
+
+// Magnitudes are arrays of 32-bit limbs, least significant first, so that a
+// limb times a limb plus a couple more limbs always fits in a uint64_t.
+
+// Below this many limbs in the shorter operand, multiplication is done the
+// schoolbook way; above it, Karatsuba's three half-size products win.
+#define KARATSUBA_THRESHOLD 32
+
+// A read-only view of an integer as a sign and a magnitude without high zero
+// limbs. A fixnum's magnitude is spelled out in small, so that every integer
+// can be handled as limbs.
+typedef struct Integer {
+  int negative;
+  int length;
+  const uint32_t *limbs;
+  uint32_t small[2];
+} Integer;
+
+uint32_t *limbsOf(Value *big) {
+  return (uint32_t *) (big + 1);
+}
+
+int isInteger(Value *value) {
+  return isFixnum(value) || typeOf(value) == BIGNUM_TYPE;
+}
+
+void viewInteger(Value *value, Integer *view) {
+  if (isFixnum(value)) {
+    int64_t i = intOf(value);
+    uint64_t magnitude = i < 0 ? -(uint64_t) i : (uint64_t) i;
+    view->negative = i < 0;
+    view->small[0] = (uint32_t) magnitude;
+    view->small[1] = (uint32_t) (magnitude >> 32);
+    view->length = view->small[1] != 0 ? 2 : view->small[0] != 0 ? 1 : 0;
+    view->limbs = view->small;
+  } else {
+    view->negative = value->big.negative;
+    view->length = value->big.length;
+    view->limbs = limbsOf(value);
+  }
+}
+
+// Scratch space for intermediate magnitudes, which never outlive the
+// operation that needs them.
+uint32_t *scratchLimbs(int count) {
+  uint32_t *limbs = malloc(sizeof(uint32_t) * (count > 0 ? count : 1));
+  if (limbs == NULL) {
+    printf("Memory error: out of memory\n");
+    texit(1);
+  }
+  return limbs;
+}
+
+// Allocates a non-negative bignum with room for length limbs, all zero.
+Value *makeBignum(int length) {
+  Value *big = gcAlloc(sizeof(Value) + sizeof(uint32_t) * length, GC_VALUE);
+  big->type = BIGNUM_TYPE;
+  big->big.negative = 0;
+  big->big.length = length;
+  memset(limbsOf(big), 0, sizeof(uint32_t) * length);
+  return big;
+}
+
+// Drops a freshly computed bignum's high zero limbs, and returns a fixnum
+// instead if it turns out to fit in one.
+Value *normalize(Value *big) {
+  uint32_t *limbs = limbsOf(big);
+  int length = big->big.length;
+  while (length > 0 && limbs[length - 1] == 0) {
+    length--;
+  }
+  big->big.length = length;
+
+  if (length <= 2) {
+    uint64_t magnitude = length == 0 ? 0 : limbs[0];
+    if (length == 2) {
+      magnitude |= (uint64_t) limbs[1] << 32;
+    }
+    if (!big->big.negative && magnitude <= (uint64_t) FIXNUM_MAX) {
+      return makeInt((intptr_t) magnitude);
+    } else if (big->big.negative && magnitude <= (uint64_t) FIXNUM_MAX + 1) {
+      return makeInt((intptr_t) -(int64_t) magnitude);
+    }
+  }
+  return big;
+}
+
+Value *makeInteger(int64_t i) {
+  if (i >= FIXNUM_MIN && i <= FIXNUM_MAX) {
+    return makeInt((intptr_t) i);
+  }
+  uint64_t magnitude = i < 0 ? -(uint64_t) i : (uint64_t) i;
+  Value *big = makeBignum(2);
+  big->big.negative = i < 0;
+  limbsOf(big)[0] = (uint32_t) magnitude;
+  limbsOf(big)[1] = (uint32_t) (magnitude >> 32);
+  return normalize(big);
+}
+
+int compareMagnitudes(const uint32_t *a, int aLength,
+                      const uint32_t *b, int bLength) {
+  if (aLength != bLength) {
+    return aLength < bLength ? -1 : 1;
+  }
+  for (int i = aLength - 1; i >= 0; i--) {
+    if (a[i] != b[i]) {
+      return a[i] < b[i] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+// out = a + b, where aLength >= bLength. out needs aLength + 1 limbs.
+void addMagnitudes(const uint32_t *a, int aLength,
+                   const uint32_t *b, int bLength, uint32_t *out) {
+  uint64_t carry = 0;
+  for (int i = 0; i < aLength; i++) {
+    carry += (uint64_t) a[i] + (i < bLength ? b[i] : 0);
+    out[i] = (uint32_t) carry;
+    carry >>= 32;
+  }
+  out[aLength] = (uint32_t) carry;
+}
+
+// out = a - b, where a >= b. out needs aLength limbs.
+void subtractMagnitudes(const uint32_t *a, int aLength,
+                        const uint32_t *b, int bLength, uint32_t *out) {
+  uint64_t borrow = 0;
+  for (int i = 0; i < aLength; i++) {
+    uint64_t difference = (uint64_t) a[i] - (i < bLength ? b[i] : 0) - borrow;
+    out[i] = (uint32_t) difference;
+    borrow = (difference >> 32) & 1;
+  }
+}
+
+// out += a, carrying as far up out's outLength limbs as needed.
+void addInto(uint32_t *out, int outLength, const uint32_t *a, int aLength) {
+  uint64_t carry = 0;
+  int i;
+  for (i = 0; i < aLength; i++) {
+    carry += (uint64_t) out[i] + a[i];
+    out[i] = (uint32_t) carry;
+    carry >>= 32;
+  }
+  for (; carry != 0 && i < outLength; i++) {
+    carry += out[i];
+    out[i] = (uint32_t) carry;
+    carry >>= 32;
+  }
+}
+
+// out -= a, where out >= a, borrowing as far up out's outLength limbs as
+// needed.
+void subtractFrom(uint32_t *out, int outLength, const uint32_t *a, int aLength) {
+  uint64_t borrow = 0;
+  int i;
+  for (i = 0; i < aLength; i++) {
+    uint64_t difference = (uint64_t) out[i] - a[i] - borrow;
+    out[i] = (uint32_t) difference;
+    borrow = (difference >> 32) & 1;
+  }
+  for (; borrow != 0 && i < outLength; i++) {
+    uint64_t difference = (uint64_t) out[i] - borrow;
+    out[i] = (uint32_t) difference;
+    borrow = (difference >> 32) & 1;
+  }
+}
+
+void multiplyMagnitudes(const uint32_t *a, int aLength,
+                        const uint32_t *b, int bLength, uint32_t *out);
+
+void schoolbookMultiply(const uint32_t *a, int aLength,
+                        const uint32_t *b, int bLength, uint32_t *out) {
+  memset(out, 0, sizeof(uint32_t) * (aLength + bLength));
+  for (int i = 0; i < bLength; i++) {
+    uint64_t carry = 0;
+    for (int j = 0; j < aLength; j++) {
+      carry += (uint64_t) a[j] * b[i] + out[i + j];
+      out[i + j] = (uint32_t) carry;
+      carry >>= 32;
+    }
+    out[i + aLength] = (uint32_t) carry;
+  }
+}
+
+// Splits both operands at half the limbs of a, which must be the longer, and
+// makes do with three products of that size rather than four:
+// (a1 B + a0)(b1 B + b0) = a1 b1 B^2 + ((a1 + a0)(b1 + b0) - a1 b1 - a0 b0) B
+// + a0 b0. b must be longer than the split, so that b1 is not empty.
+void karatsubaMultiply(const uint32_t *a, int aLength,
+                       const uint32_t *b, int bLength, uint32_t *out) {
+  int half = aLength / 2;
+  int outLength = aLength + bLength;
+
+  int aSumLength = aLength - half + 1;
+  int bSumLength = (bLength - half > half ? bLength - half : half) + 1;
+  uint32_t *aSum = scratchLimbs(aSumLength + bSumLength);
+  uint32_t *bSum = aSum + aSumLength;
+  addMagnitudes(a + half, aLength - half, a, half, aSum);
+  if (bLength - half >= half) {
+    addMagnitudes(b + half, bLength - half, b, half, bSum);
+  } else {
+    addMagnitudes(b, half, b + half, bLength - half, bSum);
+  }
+
+  int middleLength = aSumLength + bSumLength;
+  uint32_t *middle = scratchLimbs(middleLength);
+  multiplyMagnitudes(aSum, aSumLength, bSum, bSumLength, middle);
+
+  // The low and high products go straight to where they belong in out, and
+  // are subtracted from the middle one before it is added in.
+  multiplyMagnitudes(a, half, b, half, out);
+  multiplyMagnitudes(a + half, aLength - half, b + half, bLength - half,
+                     out + 2 * half);
+  subtractFrom(middle, middleLength, out, 2 * half);
+  subtractFrom(middle, middleLength, out + 2 * half, outLength - 2 * half);
+  addInto(out + half, outLength - half, middle,
+          middleLength < outLength - half ? middleLength : outLength - half);
+
+  free(aSum);
+  free(middle);
+}
+
+// out = a * b. out needs aLength + bLength limbs, and every one is written.
+void multiplyMagnitudes(const uint32_t *a, int aLength,
+                        const uint32_t *b, int bLength, uint32_t *out) {
+  if (aLength < bLength) {
+    const uint32_t *swap = a;
+    a = b;
+    b = swap;
+    int swapLength = aLength;
+    aLength = bLength;
+    bLength = swapLength;
+  }
+
+  if (bLength < KARATSUBA_THRESHOLD) {
+    schoolbookMultiply(a, aLength, b, bLength, out);
+  } else if (2 * bLength <= aLength) {
+    // Too lopsided to split evenly, so multiply b by a bLength-sized piece
+    // of a at a time.
+    memset(out, 0, sizeof(uint32_t) * (aLength + bLength));
+    uint32_t *product = scratchLimbs(2 * bLength);
+    for (int i = 0; i < aLength; i += bLength) {
+      int pieceLength = aLength - i < bLength ? aLength - i : bLength;
+      multiplyMagnitudes(a + i, pieceLength, b, bLength, product);
+      addInto(out + i, aLength + bLength - i, product, pieceLength + bLength);
+    }
+    free(product);
+  } else {
+    karatsubaMultiply(a, aLength, b, bLength, out);
+  }
+}
+
+// Long division, as in Knuth's Algorithm D: a by b, where aLength >= bLength
+// and b has no high zero limbs. The quotient's aLength - bLength + 1 limbs go
+// in quotient and the remainder's bLength limbs in remainder.
+void divideMagnitudes(const uint32_t *a, int aLength,
+                      const uint32_t *b, int bLength,
+                      uint32_t *quotient, uint32_t *remainder) {
+  if (bLength == 1) {
+    uint64_t rest = 0;
+    for (int i = aLength - 1; i >= 0; i--) {
+      uint64_t current = (rest << 32) | a[i];
+      quotient[i] = (uint32_t) (current / b[0]);
+      rest = current % b[0];
+    }
+    remainder[0] = (uint32_t) rest;
+    return;
+  }
+
+  // Shift both so that b's top limb has its high bit set, which keeps each
+  // estimated quotient limb at most two too big.
+  int shift = 0;
+  while ((b[bLength - 1] << shift & 0x80000000u) == 0) {
+    shift++;
+  }
+  uint32_t *bShifted = scratchLimbs(bLength);
+  uint32_t *aShifted = scratchLimbs(aLength + 1);
+  for (int i = bLength - 1; i > 0; i--) {
+    bShifted[i] = b[i] << shift | (shift ? b[i - 1] >> (32 - shift) : 0);
+  }
+  bShifted[0] = b[0] << shift;
+  aShifted[aLength] = shift ? a[aLength - 1] >> (32 - shift) : 0;
+  for (int i = aLength - 1; i > 0; i--) {
+    aShifted[i] = a[i] << shift | (shift ? a[i - 1] >> (32 - shift) : 0);
+  }
+  aShifted[0] = a[0] << shift;
+
+  uint32_t top = bShifted[bLength - 1];
+  uint32_t next = bShifted[bLength - 2];
+  for (int j = aLength - bLength; j >= 0; j--) {
+    uint64_t numerator = (uint64_t) aShifted[j + bLength] << 32 |
+                         aShifted[j + bLength - 1];
+    uint64_t guess = numerator / top;
+    uint64_t rest = numerator % top;
+    while (guess >> 32 != 0 ||
+           guess * next > (rest << 32 | aShifted[j + bLength - 2])) {
+      guess--;
+      rest += top;
+      if (rest >> 32 != 0) {
+        break;
+      }
+    }
+
+    // Subtract guess * b from the current window of a.
+    int64_t borrow = 0;
+    int64_t difference;
+    for (int i = 0; i < bLength; i++) {
+      uint64_t product = guess * bShifted[i];
+      difference = (int64_t) aShifted[i + j] - borrow -
+                   (int64_t) (product & 0xffffffffu);
+      aShifted[i + j] = (uint32_t) difference;
+      borrow = (int64_t) (product >> 32) - (difference >> 32);
+    }
+    difference = (int64_t) aShifted[j + bLength] - borrow;
+    aShifted[j + bLength] = (uint32_t) difference;
+
+    // The guess was one too big after all, so add b back once.
+    quotient[j] = (uint32_t) guess;
+    if (difference < 0) {
+      quotient[j]--;
+      uint64_t carry = 0;
+      for (int i = 0; i < bLength; i++) {
+        carry += (uint64_t) aShifted[i + j] + bShifted[i];
+        aShifted[i + j] = (uint32_t) carry;
+        carry >>= 32;
+      }
+      aShifted[j + bLength] += (uint32_t) carry;
+    }
+  }
+
+  for (int i = 0; i < bLength; i++) {
+    remainder[i] = aShifted[i] >> shift |
+                   (shift ? aShifted[i + 1] << (32 - shift) : 0);
+  }
+  free(bShifted);
+  free(aShifted);
+}
+
+// a + b when bNegative is b's sign, and a - b when it is the opposite.
+Value *addSigned(Integer *a, Integer *b, int bNegative) {
+  Value *result;
+  if (a->negative == bNegative) {
+    Integer *longer = a->length >= b->length ? a : b;
+    Integer *shorter = longer == a ? b : a;
+    result = makeBignum(longer->length + 1);
+    addMagnitudes(longer->limbs, longer->length,
+                  shorter->limbs, shorter->length, limbsOf(result));
+    result->big.negative = bNegative;
+  } else if (compareMagnitudes(a->limbs, a->length,
+                               b->limbs, b->length) >= 0) {
+    result = makeBignum(a->length);
+    subtractMagnitudes(a->limbs, a->length, b->limbs, b->length,
+                       limbsOf(result));
+    result->big.negative = a->negative;
+  } else {
+    result = makeBignum(b->length);
+    subtractMagnitudes(b->limbs, b->length, a->limbs, a->length,
+                       limbsOf(result));
+    result->big.negative = bNegative;
+  }
+  return normalize(result);
+}
+
+Value *integerAdd(Value *a, Value *b) {
+  // Two fixnums have a bit to spare in an int64_t, so their sum cannot
+  // overflow it.
+  if (isFixnum(a) && isFixnum(b)) {
+    return makeInteger((int64_t) intOf(a) + intOf(b));
+  }
+  Integer aView, bView;
+  viewInteger(a, &aView);
+  viewInteger(b, &bView);
+  return addSigned(&aView, &bView, bView.negative);
+}
+
+Value *integerSubtract(Value *a, Value *b) {
+  if (isFixnum(a) && isFixnum(b)) {
+    return makeInteger((int64_t) intOf(a) - intOf(b));
+  }
+  Integer aView, bView;
+  viewInteger(a, &aView);
+  viewInteger(b, &bView);
+  return addSigned(&aView, &bView, !bView.negative);
+}
+
+// Sets *product to x * y and returns 1, or returns 0 if it would overflow.
+int multiplyFits(int64_t x, int64_t y, int64_t *product) {
+#if defined(__GNUC__)
+  return !__builtin_mul_overflow(x, y, product);
+#else
+  if (x > -INT32_MAX && x < INT32_MAX && y > -INT32_MAX && y < INT32_MAX) {
+    *product = x * y;
+    return 1;
+  }
+  return 0;
+#endif
+}
+
+Value *integerMultiply(Value *a, Value *b) {
+  int64_t product;
+  if (isFixnum(a) && isFixnum(b) && multiplyFits(intOf(a), intOf(b), &product)) {
+    return makeInteger(product);
+  }
+  Integer aView, bView;
+  viewInteger(a, &aView);
+  viewInteger(b, &bView);
+  if (aView.length == 0 || bView.length == 0) {
+    return makeInt(0);
+  }
+  Value *result = makeBignum(aView.length + bView.length);
+  multiplyMagnitudes(aView.limbs, aView.length, bView.limbs, bView.length,
+                     limbsOf(result));
+  result->big.negative = aView.negative != bView.negative;
+  return normalize(result);
+}
+
+Value *integerDivide(Value *a, Value *b, Value **remainder) {
+  if (isFixnum(a) && isFixnum(b)) {
+    if (remainder != NULL) {
+      *remainder = makeInt(intOf(a) % intOf(b));
+    }
+    return makeInteger((int64_t) intOf(a) / intOf(b));
+  }
+
+  Integer aView, bView;
+  viewInteger(a, &aView);
+  viewInteger(b, &bView);
+  if (aView.length < bView.length) {
+    if (remainder != NULL) {
+      *remainder = a;
+    }
+    return makeInt(0);
+  }
+
+  Value *quotient = makeBignum(aView.length - bView.length + 1);
+  Value *rest = makeBignum(bView.length);
+  divideMagnitudes(aView.limbs, aView.length, bView.limbs, bView.length,
+                   limbsOf(quotient), limbsOf(rest));
+  quotient->big.negative = aView.negative != bView.negative;
+  rest->big.negative = aView.negative;
+  if (remainder != NULL) {
+    *remainder = normalize(rest);
+  }
+  return normalize(quotient);
+}
+
+int integerCompare(Value *a, Value *b) {
+  if (isFixnum(a) && isFixnum(b)) {
+    return (intOf(a) > intOf(b)) - (intOf(a) < intOf(b));
+  }
+  Integer aView, bView;
+  viewInteger(a, &aView);
+  viewInteger(b, &bView);
+  if (aView.negative != bView.negative) {
+    return aView.negative ? -1 : 1;
+  }
+  int order = compareMagnitudes(aView.limbs, aView.length,
+                                bView.limbs, bView.length);
+  return aView.negative ? -order : order;
+}
+
+double integerToDouble(Value *a) {
+  if (isFixnum(a)) {
+    return (double) intOf(a);
+  }
+  double result = 0;
+  uint32_t *limbs = limbsOf(a);
+  for (int i = a->big.length - 1; i >= 0; i--) {
+    result = result * 4294967296.0 + limbs[i];
+  }
+  return a->big.negative ? -result : result;
+}
+
+int integerToInt64(Value *a, int64_t *i) {
+  Integer view;
+  viewInteger(a, &view);
+  if (view.length > 2) {
+    return 0;
+  }
+  uint64_t magnitude = view.length == 0 ? 0 : view.limbs[0];
+  if (view.length == 2) {
+    magnitude |= (uint64_t) view.limbs[1] << 32;
+  }
+  if (!view.negative && magnitude <= INT64_MAX) {
+    *i = (int64_t) magnitude;
+    return 1;
+  } else if (view.negative && magnitude <= (uint64_t) INT64_MAX + 1) {
+    *i = (int64_t) -magnitude;
+    return 1;
+  }
+  return 0;
+}
+
+// magnitude = magnitude * factor + addend, growing *length by a limb if the
+// carry needs one.
+void multiplyAddSmall(uint32_t *magnitude, int *length,
+                      uint32_t factor, uint32_t addend) {
+  uint64_t carry = addend;
+  for (int i = 0; i < *length; i++) {
+    carry += (uint64_t) magnitude[i] * factor;
+    magnitude[i] = (uint32_t) carry;
+    carry >>= 32;
+  }
+  if (carry != 0) {
+    magnitude[(*length)++] = (uint32_t) carry;
+  }
+}
+
+Value *readInteger(char *digits, int length) {
+  int negative = 0;
+  if (length > 0 && (digits[0] == '+' || digits[0] == '-')) {
+    negative = digits[0] == '-';
+    digits++;
+    length--;
+  }
+
+  // Up to 18 digits always fit in an int64_t.
+  if (length <= 18) {
+    int64_t value = 0;
+    for (int i = 0; i < length; i++) {
+      value = value * 10 + (digits[i] - '0');
+    }
+    return makeInteger(negative ? -value : value);
+  }
+
+  // Otherwise take nine digits at a time, since 10^9 fits in a limb.
+  Value *big = makeBignum(length / 9 + 2);
+  uint32_t *magnitude = limbsOf(big);
+  int used = 0;
+  int i = 0;
+  while (i < length) {
+    int chunk = i == 0 && length % 9 != 0 ? length % 9 : 9;
+    uint32_t factor = 1;
+    uint32_t value = 0;
+    for (int end = i + chunk; i < end; i++) {
+      factor *= 10;
+      value = value * 10 + (digits[i] - '0');
+    }
+    multiplyAddSmall(magnitude, &used, factor, value);
+  }
+  big->big.negative = negative;
+  return normalize(big);
+}
+
+void printInteger(Value *a) {
+  if (isFixnum(a)) {
+    printf("%lld", (long long) intOf(a));
+    return;
+  }
+
+  // Peel off nine decimal digits at a time from a copy of the magnitude.
+  int length = a->big.length;
+  uint32_t *magnitude = scratchLimbs(length);
+  uint32_t *chunks = scratchLimbs(2 * length + 1);
+  memcpy(magnitude, limbsOf(a), sizeof(uint32_t) * length);
+  int chunkCount = 0;
+  while (length > 0) {
+    uint64_t rest = 0;
+    for (int i = length - 1; i >= 0; i--) {
+      uint64_t current = (rest << 32) | magnitude[i];
+      magnitude[i] = (uint32_t) (current / 1000000000u);
+      rest = current % 1000000000u;
+    }
+    chunks[chunkCount++] = (uint32_t) rest;
+    while (length > 0 && magnitude[length - 1] == 0) {
+      length--;
+    }
+  }
+
+  printf("%s%u", a->big.negative ? "-" : "", chunks[chunkCount - 1]);
+  for (int i = chunkCount - 2; i >= 0; i--) {
+    printf("%09u", chunks[i]);
+  }
+  free(magnitude);
+  free(chunks);
+}
@@ -0,0 +1,42 @@
+#include "value.h"
+
+#ifndef _BIGNUM
+#define _BIGNUM
+
+// Exact integers are fixnums when they fit and BIGNUM_TYPE values when they
+// do not. Every function here accepts either kind, and returns a fixnum
+// whenever the result fits, so each integer has only one representation and
+// two integers are equal exactly when integerCompare says so.
+
+// Whether value is an exact integer of either kind.
+int isInteger(Value *value);
+
+// Returns i as a fixnum if it fits, or as a bignum.
+Value *makeInteger(int64_t i);
+
+Value *integerAdd(Value *a, Value *b);
+Value *integerSubtract(Value *a, Value *b);
+Value *integerMultiply(Value *a, Value *b);
+
+// Divides a by b, rounding the quotient toward zero, and returns the quotient.
+// The remainder, which has the sign of a, goes in *remainder unless it is
+// NULL. b must not be zero.
+Value *integerDivide(Value *a, Value *b, Value **remainder);
+
+// Returns a negative number, zero or a positive number as a is less than,
+// equal to or greater than b.
+int integerCompare(Value *a, Value *b);
+
+double integerToDouble(Value *a);
+
+// Sets *i to a and returns 1 if it fits in an int64_t, and returns 0 if not.
+int integerToInt64(Value *a, int64_t *i);
+
+// Reads the integer written in the first length characters at digits, which
+// are decimal digits after an optional sign.
+Value *readInteger(char *digits, int length);
+
+// Prints an integer in decimal.
+void printInteger(Value *a);
+
+#endif
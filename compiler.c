@@ -0,0 +1,436 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "compiler.h"
+#include "value.h"
+#include "linkedlist.h"
+#include "talloc.h"
+#include "gc.h"
+#include "vm.h"
+#include "profile.h"
+
+// The Code being built for one lambda body or top-level form. Instructions
+// and constants are collected in talloc'd buffers and copied into a Code
+// object when the body is finished. Compiling never reaches a safe point, so
+// the values in the buffers do not need protecting.
+typedef struct Compiler {
+  int *instructions;
+  int length;
+  int capacity;
+  Value **constants;
+  int constantCount;
+  int constantCapacity;
+} Compiler;
+
+void compileExpr(Compiler *compiler, Value *expr, int tail);
+
+// Doubles a buffer allocated with talloc, abandoning the old one to the arena.
+void *growBuffer(void *buffer, int count, int *capacity, size_t size) {
+  int newCapacity = *capacity == 0 ? 32 : *capacity * 2;
+  void *newBuffer = talloc(size * newCapacity);
+  if (count > 0) {
+    memcpy(newBuffer, buffer, size * count);
+  }
+  *capacity = newCapacity;
+  return newBuffer;
+}
+
+void emit(Compiler *compiler, int word) {
+  if (compiler->length == compiler->capacity) {
+    compiler->instructions = growBuffer(compiler->instructions, compiler->length,
+                                        &compiler->capacity, sizeof(int));
+  }
+  compiler->instructions[compiler->length++] = word;
+}
+
+// Returns the index of value in the constants pool, adding it if need be.
+int addConstant(Compiler *compiler, Value *value) {
+  for (int i = 0; i < compiler->constantCount; i++) {
+    if (compiler->constants[i] == value) {
+      return i;
+    }
+  }
+  if (compiler->constantCount == compiler->constantCapacity) {
+    compiler->constants = growBuffer(compiler->constants, compiler->constantCount,
+                                     &compiler->constantCapacity, sizeof(Value *));
+  }
+  compiler->constants[compiler->constantCount] = value;
+  return compiler->constantCount++;
+}
+
+void emitConstant(Compiler *compiler, Value *value) {
+  emit(compiler, OP_CONST);
+  emit(compiler, addConstant(compiler, value));
+}
+
+void emitVoid(Compiler *compiler) {
+  emitConstant(compiler, VOID_VALUE);
+}
+
+void emitError(Compiler *compiler, char *error) {
+  Value *message = gcValue();
+  message->type = STR_TYPE;
+  message->s = error;
+  message->length = strlen(error);
+  emit(compiler, OP_ERROR);
+  emit(compiler, addConstant(compiler, message));
+}
+
+// Emits a jump with its target left blank, and returns where the target goes.
+int emitJump(Compiler *compiler, opcode op) {
+  emit(compiler, op);
+  emit(compiler, -1);
+  return compiler->length - 1;
+}
+
+// Points the jump whose target is at the given index at the next instruction.
+void patchJump(Compiler *compiler, int at) {
+  compiler->instructions[at] = compiler->length;
+}
+
+Value *finishCode(Compiler *compiler, int arity) {
+  Code *code = gcCode(compiler->constantCount, compiler->length);
+  code->arity = arity;
+  if (compiler->constantCount > 0) {
+    memcpy(code->constants, compiler->constants,
+           sizeof(Value *) * compiler->constantCount);
+  }
+  memcpy(instructionsOf(code), compiler->instructions,
+         sizeof(int) * compiler->length);
+
+  Value *value = gcValue();
+  value->type = CODE_TYPE;
+  value->code = code;
+  return value;
+}
+
+// Compiles a sequence of expressions, keeping only the value of the last. An
+// empty body is void.
+void compileBody(Compiler *compiler, Value *body, int tail) {
+  if (body == NULL_VALUE) {
+    emitVoid(compiler);
+    return;
+  }
+  while (cdr(body) != NULL_VALUE) {
+    compileExpr(compiler, car(body), 0);
+    emit(compiler, OP_POP);
+    body = cdr(body);
+  }
+  compileExpr(compiler, car(body), tail);
+}
+
+void compileIf(Compiler *compiler, Value *args, int tail) {
+  if (length(args) != 3) {
+    emitError(compiler, "if: args != 3");
+    return;
+  }
+  compileExpr(compiler, car(args), 0);
+  int elseJump = emitJump(compiler, OP_JUMP_IF_FALSE);
+  compileExpr(compiler, car(cdr(args)), tail);
+  int endJump = emitJump(compiler, OP_JUMP);
+  patchJump(compiler, elseJump);
+  compileExpr(compiler, car(cdr(cdr(args))), tail);
+  patchJump(compiler, endJump);
+}
+
+void compileAndOr(Compiler *compiler, Value *args, opcode op, int tail) {
+  if (length(args) < 1) {
+    emitError(compiler, "too few arguments in and/or");
+    return;
+  }
+  int *ends = talloc(sizeof(int) * length(args));
+  int count = 0;
+  while (cdr(args) != NULL_VALUE) {
+    compileExpr(compiler, car(args), 0);
+    ends[count++] = emitJump(compiler, op);
+    args = cdr(args);
+  }
+  compileExpr(compiler, car(args), tail);
+  for (int i = 0; i < count; i++) {
+    patchJump(compiler, ends[i]);
+  }
+}
+
+// Returns the number of bindings in a let-style binding list, or -1 if it is
+// not a list of (symbol expression) pairs. As in eval, let and let* ignore
+// anything after a binding's expression, and letrec does not allow it.
+int countBindings(Value *bindings, syntaxType syntax) {
+  if (typeOf(bindings) != CONS_TYPE && bindings != NULL_VALUE) {
+    return -1;
+  }
+  int count = 0;
+  for (; typeOf(bindings) == CONS_TYPE; bindings = cdr(bindings)) {
+    Value *binding = car(bindings);
+    if (typeOf(binding) != CONS_TYPE || length(binding) < 2 ||
+        (syntax == LETREC_SYNTAX && length(binding) != 2) ||
+        typeOf(car(binding)) != SYMBOL_TYPE) {
+      return -1;
+    }
+    count++;
+  }
+  return count;
+}
+
+// The binding forms create frames exactly where the resolver gave them
+// scopes, so its (depth, slot) coordinates hold in the VM too.
+void compileLet(Compiler *compiler, Value *args, syntaxType syntax, int tail) {
+  if (length(args) < 2) {
+    emitError(compiler, "let: no bindings or body");
+    return;
+  }
+  Value *bindings = car(args);
+  int count = countBindings(bindings, syntax);
+  if (count < 0) {
+    emitError(compiler, "let: invalid bindings");
+    return;
+  }
+
+  int frames = 0;
+  if (syntax == LET_SYNTAX && count > 0) {
+    for (; bindings != NULL_VALUE; bindings = cdr(bindings)) {
+      compileExpr(compiler, car(cdr(car(bindings))), 0);
+    }
+    emit(compiler, OP_ENTER);
+    emit(compiler, count);
+    frames = 1;
+  } else if (syntax == LET_STAR_SYNTAX) {
+    for (; bindings != NULL_VALUE; bindings = cdr(bindings)) {
+      compileExpr(compiler, car(cdr(car(bindings))), 0);
+      emit(compiler, OP_ENTER);
+      emit(compiler, 1);
+    }
+    frames = count;
+  } else if (syntax == LETREC_SYNTAX) {
+    emit(compiler, OP_ENTER_EMPTY);
+    emit(compiler, count);
+    for (; bindings != NULL_VALUE; bindings = cdr(bindings)) {
+      compileExpr(compiler, car(cdr(car(bindings))), 0);
+    }
+    emit(compiler, OP_FILL);
+    emit(compiler, count);
+    frames = 1;
+  }
+
+  compileBody(compiler, cdr(args), tail);
+  if (!tail && frames > 0) {
+    // In tail position the frames are dropped by the return instead.
+    emit(compiler, OP_LEAVE);
+    emit(compiler, frames);
+  }
+}
+
+void compileCond(Compiler *compiler, Value *clauses, int tail) {
+  if (length(clauses) == 0) {
+    emitError(compiler, "no arguments in cond");
+    return;
+  }
+  int *ends = talloc(sizeof(int) * length(clauses));
+  int count = 0;
+  for (; clauses != NULL_VALUE; clauses = cdr(clauses)) {
+    Value *clause = car(clauses);
+    if (typeOf(clause) != CONS_TYPE) {
+      emitError(compiler, "cond: clause is not a list");
+      break;
+    }
+    Value *test = car(clause);
+    if (typeOf(test) == SYMBOL_TYPE && test->syntax == ELSE_SYNTAX) {
+      if (cdr(clauses) != NULL_VALUE) {
+        emitError(compiler, "else is not last test in cond");
+      } else {
+        compileBody(compiler, cdr(clause), tail);
+      }
+      break;
+    }
+    compileExpr(compiler, test, 0);
+    int nextJump = emitJump(compiler, OP_JUMP_IF_FALSE);
+    compileBody(compiler, cdr(clause), tail);
+    ends[count++] = emitJump(compiler, OP_JUMP);
+    patchJump(compiler, nextJump);
+    if (cdr(clauses) == NULL_VALUE) {
+      emitVoid(compiler);
+    }
+  }
+  for (int i = 0; i < count; i++) {
+    patchJump(compiler, ends[i]);
+  }
+}
+
+void compileLambda(Compiler *compiler, Value *args) {
+  if (args == NULL_VALUE || cdr(args) == NULL_VALUE) {
+    emitError(compiler, "lambda: either no params or body");
+    return;
+  }
+  Value *params = car(args);
+  if (typeOf(params) != CONS_TYPE && params != NULL_VALUE) {
+    emitError(compiler, "lambda: params must be a list");
+    return;
+  }
+  int arity = 0;
+  for (Value *param = params; param != NULL_VALUE; param = cdr(param)) {
+    if (typeOf(car(param)) != SYMBOL_TYPE) {
+      emitError(compiler, "lambda: params must be symbols");
+      return;
+    }
+    for (Value *other = cdr(param); other != NULL_VALUE; other = cdr(other)) {
+      if (car(other) == car(param)) {
+        emitError(compiler, "lambda: multiple parameters of same name");
+        return;
+      }
+    }
+    arity++;
+  }
+
+  Compiler body = {0};
+  compileBody(&body, cdr(args), 1);
+  emit(&body, OP_RETURN);
+  emit(compiler, OP_CLOSURE);
+  Value *code = finishCode(&body, arity);
+  if (profiling) {
+    code->code->line = profileSourceLine(args);
+  }
+  emit(compiler, addConstant(compiler, code));
+}
+
+void compileDefine(Compiler *compiler, Value *args) {
+  if (args == NULL_VALUE) {
+    emitError(compiler, "define: empty arguments");
+    return;
+  } else if (typeOf(car(args)) != SYMBOL_TYPE) {
+    emitError(compiler, "define: not a symbol");
+    return;
+  } else if (cdr(args) == NULL_VALUE || car(cdr(args)) == NULL_VALUE) {
+    emitError(compiler, "define: empty body");
+    return;
+  }
+  compileExpr(compiler, car(cdr(args)), 0);
+  emit(compiler, OP_DEFINE);
+  emit(compiler, addConstant(compiler, car(args)));
+  emitVoid(compiler);
+}
+
+void compileSet(Compiler *compiler, Value *args) {
+  if (args == NULL_VALUE) {
+    emitError(compiler, "no arguments passed to set!");
+    return;
+  } else if (cdr(args) == NULL_VALUE) {
+    emitError(compiler, "no value to bind variable to in set!");
+    return;
+  }
+  Value *variable = car(args);
+  if (typeOf(variable) != SYMBOL_TYPE && typeOf(variable) != LOCAL_TYPE) {
+    emitError(compiler, "non-symbol cannot be bound to a value in set!");
+    return;
+  }
+  compileExpr(compiler, car(cdr(args)), 0);
+  if (typeOf(variable) == SYMBOL_TYPE) {
+    emit(compiler, OP_SET_GLOBAL);
+    emit(compiler, addConstant(compiler, variable));
+  } else if (variable->ref.depth == 0) {
+    emit(compiler, OP_SET_LOCAL);
+    emit(compiler, variable->ref.slot);
+  } else {
+    emit(compiler, OP_SET_FREE);
+    emit(compiler, variable->ref.depth);
+    emit(compiler, variable->ref.slot);
+  }
+  emitVoid(compiler);
+}
+
+// Arguments are pushed left to right and the procedure last, matching the
+// order eval evaluates them in.
+void compileCall(Compiler *compiler, Value *tree, int tail) {
+  int count = 0;
+  for (Value *args = cdr(tree); args != NULL_VALUE; args = cdr(args)) {
+    compileExpr(compiler, car(args), 0);
+    count++;
+  }
+  compileExpr(compiler, car(tree), 0);
+  emit(compiler, tail ? OP_TAIL_CALL : OP_CALL);
+  emit(compiler, count);
+}
+
+void compileForm(Compiler *compiler, Value *tree, int tail) {
+  Value *first = car(tree);
+  Value *args = cdr(tree);
+
+  syntaxType syntax = NO_SYNTAX;
+  if (typeOf(first) == SYMBOL_TYPE) {
+    syntax = first->syntax;
+  }
+
+  switch (syntax) {
+    case IF_SYNTAX:
+      compileIf(compiler, args, tail);
+      break;
+    case LET_SYNTAX:
+    case LET_STAR_SYNTAX:
+    case LETREC_SYNTAX:
+      compileLet(compiler, args, syntax, tail);
+      break;
+    case QUOTE_SYNTAX:
+      if (length(args) != 1) {
+        emitError(compiler, "quote: more than 1 argument");
+      } else {
+        emitConstant(compiler, car(args));
+      }
+      break;
+    case DEFINE_SYNTAX:
+      compileDefine(compiler, args);
+      break;
+    case LAMBDA_SYNTAX:
+      compileLambda(compiler, args);
+      break;
+    case COND_SYNTAX:
+      compileCond(compiler, args, tail);
+      break;
+    case SET_SYNTAX:
+      compileSet(compiler, args);
+      break;
+    case BEGIN_SYNTAX:
+      compileBody(compiler, args, tail);
+      break;
+    case AND_SYNTAX:
+      compileAndOr(compiler, args, OP_AND_JUMP, tail);
+      break;
+    case OR_SYNTAX:
+      compileAndOr(compiler, args, OP_OR_JUMP, tail);
+      break;
+    default:
+      compileCall(compiler, tree, tail);
+      break;
+  }
+}
+
+// Compiles expr so that it leaves its value on the stack. In tail position a
+// call becomes a tail call, whose callee returns straight to our caller.
+void compileExpr(Compiler *compiler, Value *expr, int tail) {
+  switch (typeOf(expr)) {
+    case SYMBOL_TYPE:
+      emit(compiler, OP_GLOBAL);
+      emit(compiler, addConstant(compiler, expr));
+      break;
+    case LOCAL_TYPE:
+      if (expr->ref.depth == 0) {
+        emit(compiler, OP_LOCAL);
+        emit(compiler, expr->ref.slot);
+      } else {
+        emit(compiler, OP_FREE);
+        emit(compiler, expr->ref.depth);
+        emit(compiler, expr->ref.slot);
+      }
+      break;
+    case CONS_TYPE:
+      compileForm(compiler, expr, tail);
+      break;
+    default:
+      emitConstant(compiler, expr);
+      break;
+  }
+}
+
+Value *compile(Value *expr) {
+  Compiler compiler = {0};
+  compileExpr(&compiler, expr, 1);
+  emit(&compiler, OP_RETURN);
+  return finishCode(&compiler, 0);
+}
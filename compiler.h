@@ -0,0 +1,12 @@
+#include "value.h"
+
+#ifndef _COMPILER
+#define _COMPILER
+
+// Compiles one resolved top-level form into a CODE_TYPE value that the VM can
+// run in the global frame. Lambdas inside it become nested Code constants.
+// Malformed forms compile to an OP_ERROR where they would have been
+// evaluated, so errors surface at the same point as under eval.
+Value *compile(Value *expr);
+
+#endif
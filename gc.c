@@ -0,0 +1,492 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "gc.h"
+#include "talloc.h"
+#include "value.h"
+#include "stats.h"
+
+// The heap has two generations. New objects are bumped into the nursery; a
+// minor collection copies the ones still reachable into the old space and
+// resets the nursery, so its cost depends only on what survives. The old
+// space is collected by mark-and-sweep: small objects are recycled through
+// free lists segregated by size, and large ones get their own talloc block and
+// are handed back with trelease when they die. All of the memory comes from
+// talloc, so tfree still cleans up everything at exit.
+//
+// Every object is preceded by a header recording its size and kind.
+typedef struct GcHeader {
+  uint32_t size;       // payload bytes, a multiple of GC_GRAIN
+  uint8_t kind;
+  uint8_t marked;
+  uint8_t young;       // still in the nursery
+  uint8_t remembered;  // old object on the remembered set
+} GcHeader;
+
+typedef struct GcChunk {
+  struct GcChunk *next;
+  char *top;
+  char *end;
+} GcChunk;
+
+typedef struct GcLarge {
+  struct GcLarge *next;
+  GcHeader *header;
+} GcLarge;
+
+#define GC_GRAIN 8
+#define GC_CHUNK_SIZE (256 * 1024)
+#define GC_NURSERY_SIZE (512 * 1024)
+#define GC_SMALL_LIMIT (TALLOC_LARGE_OBJECT - 2 * sizeof(GcHeader))
+#define GC_MIN_THRESHOLD (1024 * 1024)
+
+GcChunk *gcNursery;       // the current nursery chunk, then any overflow
+int gcNurseryFull;        // a minor collection is due
+GcChunk *gcChunks;        // old space
+GcLarge *gcLargeObjects;
+void *gcFreeLists[GC_SMALL_LIMIT / GC_GRAIN + 1];
+
+size_t gcLiveBytes;       // old space bytes that survived the last major
+size_t gcAllocatedBytes;  // old space bytes allocated since then
+size_t gcThreshold = GC_MIN_THRESHOLD;
+
+// Running totals for gcPrintStats.
+size_t gcObjectsAllocated;
+size_t gcBytesAllocated;
+int gcMinorCollections;
+int gcMajorCollections;
+size_t gcHeapLimit;
+
+void ***gcRootStack;
+int gcRootTop;
+int gcRootCapacity;
+
+#define GC_MAX_TRACERS 4
+void (*gcRootTracers[GC_MAX_TRACERS])(void (*visit)(void **));
+int gcRootTracerCount;
+
+// Old objects that may point into the nursery.
+void **gcRemembered;
+int gcRememberedTop;
+int gcRememberedCapacity;
+
+// Objects still to be traced, during either kind of collection.
+void **gcWork;
+int gcWorkTop;
+int gcWorkCapacity;
+
+GcHeader *headerOf(void *object) {
+  return (GcHeader *) object - 1;
+}
+
+void *payloadOf(GcHeader *header) {
+  return header + 1;
+}
+
+// Doubles a pointer array allocated with talloc. The old array is abandoned to
+// the arena, which is fine since these only ever grow a handful of times.
+void **growArray(void **array, int top, int *capacity) {
+  int newCapacity = *capacity == 0 ? 256 : *capacity * 2;
+  void **newArray = talloc(sizeof(void *) * newCapacity);
+  if (top > 0) {
+    memcpy(newArray, array, sizeof(void *) * top);
+  }
+  *capacity = newCapacity;
+  return newArray;
+}
+
+void gcGrowRoots() {
+  gcRootStack = (void ***) growArray((void **) gcRootStack, gcRootTop,
+                                     &gcRootCapacity);
+}
+
+void gcAddRootTracer(void (*tracer)(void (*visit)(void **))) {
+  if (gcRootTracerCount == GC_MAX_TRACERS) {
+    printf("Memory error: too many root tracers\n");
+    texit(1);
+  }
+  gcRootTracers[gcRootTracerCount++] = tracer;
+}
+
+void gcSetHeapLimit(size_t bytes) {
+  gcHeapLimit = bytes;
+}
+
+void remember(GcHeader *header) {
+  header->remembered = 1;
+  if (gcRememberedTop == gcRememberedCapacity) {
+    gcRemembered = growArray(gcRemembered, gcRememberedTop,
+                             &gcRememberedCapacity);
+  }
+  gcRemembered[gcRememberedTop++] = payloadOf(header);
+}
+
+void gcWriteBarrier(void *object) {
+  GcHeader *header = headerOf(object);
+  if (!header->young && !header->remembered) {
+    remember(header);
+  }
+}
+
+GcChunk *newGcChunk(size_t size) {
+  GcChunk *chunk = talloc(size);
+  chunk->top = (char *) (chunk + 1);
+  chunk->end = (char *) chunk + size;
+  chunk->next = NULL;
+  return chunk;
+}
+
+void *allocLarge(size_t size, gcKind kind) {
+  GcLarge *large = talloc(sizeof(GcLarge) + sizeof(GcHeader) + size);
+  GcHeader *header = (GcHeader *) (large + 1);
+  header->size = size;
+  header->kind = kind;
+  header->marked = 0;
+  header->young = 0;
+  header->remembered = 0;
+  large->header = header;
+  large->next = gcLargeObjects;
+  gcLargeObjects = large;
+  return payloadOf(header);
+}
+
+// Allocates directly in the old space.
+void *allocOld(size_t size, gcKind kind) {
+  gcAllocatedBytes += size + sizeof(GcHeader);
+  if (size > GC_SMALL_LIMIT) {
+    return allocLarge(size, kind);
+  }
+
+  GcHeader *header;
+  void **freeList = &gcFreeLists[size / GC_GRAIN];
+  if (*freeList != NULL) {
+    header = headerOf(*freeList);
+    *freeList = *(void **) *freeList;
+  } else {
+    size_t needed = sizeof(GcHeader) + size;
+    if (gcChunks == NULL || gcChunks->top + needed > gcChunks->end) {
+      GcChunk *chunk = newGcChunk(GC_CHUNK_SIZE);
+      chunk->next = gcChunks;
+      gcChunks = chunk;
+    }
+    header = (GcHeader *) gcChunks->top;
+    gcChunks->top += needed;
+    header->size = size;
+  }
+  header->kind = kind;
+  header->marked = 0;
+  header->young = 0;
+  header->remembered = 0;
+  return payloadOf(header);
+}
+
+void *gcAlloc(size_t size, gcKind kind) {
+  size = (size + GC_GRAIN - 1) & ~(size_t) (GC_GRAIN - 1);
+  gcObjectsAllocated++;
+  gcBytesAllocated += size;
+  if (size > GC_SMALL_LIMIT) {
+    // Too big to be worth copying. It starts out remembered, since whatever
+    // it gets filled with may well be young.
+    void *object = allocOld(size, kind);
+    if (kind != GC_RAW) {
+      remember(headerOf(object));
+    }
+    return object;
+  }
+
+  size_t needed = sizeof(GcHeader) + size;
+  if (gcNursery == NULL || gcNursery->top + needed > gcNursery->end) {
+    // Collections can only happen at safe points, so keep going in an overflow
+    // chunk until the next one.
+    GcChunk *chunk = newGcChunk(GC_NURSERY_SIZE);
+    chunk->next = gcNursery;
+    gcNurseryFull = gcNursery != NULL;
+    gcNursery = chunk;
+  }
+  GcHeader *header = (GcHeader *) gcNursery->top;
+  gcNursery->top += needed;
+  header->size = size;
+  header->kind = kind;
+  header->marked = 0;
+  header->young = 1;
+  header->remembered = 0;
+  return payloadOf(header);
+}
+
+void *gcAllocPermanent(size_t size, gcKind kind) {
+  GcHeader *header = talloc(sizeof(GcHeader) + size);
+  header->size = size;
+  header->kind = kind;
+  header->marked = 1;
+  header->young = 0;
+  header->remembered = 0;
+  return payloadOf(header);
+}
+
+Value *gcValue() {
+  return gcAlloc(sizeof(Value), GC_VALUE);
+}
+
+Frame *gcFrame(int size) {
+  Frame *frame = gcAlloc(sizeof(Frame) + sizeof(Value *) * size, GC_FRAME);
+  stats.framesCreated++;
+  frame->size = size;
+  for (int i = 0; i < size; i++) {
+    frame->slots[i] = NULL;
+  }
+  return frame;
+}
+
+Code *gcCode(int constantCount, int length) {
+  Code *code = gcAlloc(sizeof(Code) + sizeof(Value *) * constantCount +
+                       sizeof(int) * length, GC_CODE);
+  code->arity = 0;
+  code->line = 0;
+  code->constantCount = constantCount;
+  code->length = length;
+  for (int i = 0; i < constantCount; i++) {
+    code->constants[i] = NULL;
+  }
+  return code;
+}
+
+void pushWork(void *object) {
+  if (gcWorkTop == gcWorkCapacity) {
+    gcWorkCapacity = gcWorkCapacity == 0 ? 1024 : gcWorkCapacity * 2;
+    gcWork = realloc(gcWork, sizeof(void *) * gcWorkCapacity);
+    if (gcWork == NULL) {
+      printf("Memory error: out of memory\n");
+      texit(1);
+    }
+  }
+  gcWork[gcWorkTop++] = object;
+}
+
+void releaseWork() {
+  free(gcWork);
+  gcWork = NULL;
+  gcWorkCapacity = 0;
+}
+
+// Calls visit on the address of every heap pointer stored in object.
+void traceObject(void *object, void (*visit)(void **)) {
+  if (headerOf(object)->kind == GC_FRAME) {
+    Frame *frame = object;
+    visit((void **) &frame->parent);
+    for (int i = 0; i < frame->size; i++) {
+      visit((void **) &frame->slots[i]);
+    }
+    return;
+  }
+  if (headerOf(object)->kind == GC_CODE) {
+    Code *code = object;
+    for (int i = 0; i < code->constantCount; i++) {
+      visit((void **) &code->constants[i]);
+    }
+    return;
+  }
+
+  Value *value = object;
+  switch (value->type) {
+    case CONS_TYPE:
+      visit((void **) &value->c.car);
+      visit((void **) &value->c.cdr);
+      break;
+    case CLOSURE_TYPE:
+      visit((void **) &value->cl.paramNames);
+      visit((void **) &value->cl.functionCode);
+      visit((void **) &value->cl.frame);
+      break;
+    case LOCAL_TYPE:
+      visit((void **) &value->ref.name);
+      break;
+    case CODE_TYPE:
+      visit((void **) &value->code);
+      break;
+    case VECTOR_TYPE:
+      for (int i = 0; i < value->vector.length; i++) {
+        visit((void **) &elementsOf(value)[i]);
+      }
+      break;
+    case HASHTABLE_TYPE:
+      visit((void **) &value->table.entries);
+      break;
+    default:
+      break;
+  }
+}
+
+// Moves a young object into the old space, leaving behind a forwarding
+// address, and updates the field to point at the copy.
+void promote(void **field) {
+  void *object = *field;
+  if (object == NULL || isImmediate(object)) {
+    return;
+  }
+  GcHeader *header = headerOf(object);
+  if (!header->young) {
+    return;
+  }
+  if (header->kind == GC_FREE) {
+    // Already copied; the first word holds the new address.
+    *field = *(void **) object;
+    return;
+  }
+  void *copy = allocOld(header->size, header->kind);
+  memcpy(copy, object, header->size);
+  header->kind = GC_FREE;
+  *(void **) object = copy;
+  *field = copy;
+  if (headerOf(copy)->kind != GC_RAW) {
+    pushWork(copy);
+  }
+}
+
+void collectMinor() {
+  gcMinorCollections++;
+  for (int i = 0; i < gcRootTop; i++) {
+    promote(gcRootStack[i]);
+  }
+  for (int i = 0; i < gcRootTracerCount; i++) {
+    gcRootTracers[i](promote);
+  }
+  for (int i = 0; i < gcRememberedTop; i++) {
+    headerOf(gcRemembered[i])->remembered = 0;
+    traceObject(gcRemembered[i], promote);
+  }
+  gcRememberedTop = 0;
+  while (gcWorkTop > 0) {
+    traceObject(gcWork[--gcWorkTop], promote);
+  }
+  releaseWork();
+
+  // Keep the first nursery chunk for reuse and release any overflow.
+  while (gcNursery->next != NULL) {
+    GcChunk *overflow = gcNursery;
+    gcNursery = gcNursery->next;
+    trelease(overflow);
+  }
+  gcNursery->top = (char *) (gcNursery + 1);
+  gcNurseryFull = 0;
+#ifdef GC_STRESS
+  // Make any pointer that was missed on its way out of the nursery fail fast.
+  memset(gcNursery->top, 0xab, gcNursery->end - gcNursery->top);
+#endif
+}
+
+void gcCollectMinor() {
+  if (gcNursery != NULL) {
+    collectMinor();
+  }
+}
+
+void mark(void **field) {
+  void *object = *field;
+  if (object == NULL || isImmediate(object)) {
+    return;
+  }
+  GcHeader *header = headerOf(object);
+  if (header->marked) {
+    return;
+  }
+  header->marked = 1;
+  if (header->kind != GC_RAW) {
+    pushWork(object);
+  }
+}
+
+// Unmarked small objects go onto the free list for their size; unmarked large
+// objects are returned to malloc.
+void sweep() {
+  memset(gcFreeLists, 0, sizeof(gcFreeLists));
+  gcLiveBytes = 0;
+
+  for (GcChunk *chunk = gcChunks; chunk != NULL; chunk = chunk->next) {
+    char *cursor = (char *) (chunk + 1);
+    while (cursor < chunk->top) {
+      GcHeader *header = (GcHeader *) cursor;
+      if (header->marked) {
+        header->marked = 0;
+        gcLiveBytes += sizeof(GcHeader) + header->size;
+      } else {
+        void **freeList = &gcFreeLists[header->size / GC_GRAIN];
+        header->kind = GC_FREE;
+        *(void **) payloadOf(header) = *freeList;
+        *freeList = payloadOf(header);
+      }
+      cursor += sizeof(GcHeader) + header->size;
+    }
+  }
+
+  GcLarge **link = &gcLargeObjects;
+  while (*link != NULL) {
+    GcLarge *large = *link;
+    if (large->header->marked) {
+      large->header->marked = 0;
+      gcLiveBytes += sizeof(GcHeader) + large->header->size;
+      link = &large->next;
+    } else {
+      *link = large->next;
+      trelease(large);
+    }
+  }
+}
+
+// Empties the nursery first, so marking only ever sees old objects.
+void collectMajor() {
+  gcCollectMinor();
+  gcMajorCollections++;
+
+  for (int i = 0; i < gcRootTop; i++) {
+    mark(gcRootStack[i]);
+    while (gcWorkTop > 0) {
+      traceObject(gcWork[--gcWorkTop], mark);
+    }
+  }
+  for (int i = 0; i < gcRootTracerCount; i++) {
+    gcRootTracers[i](mark);
+    while (gcWorkTop > 0) {
+      traceObject(gcWork[--gcWorkTop], mark);
+    }
+  }
+  releaseWork();
+  sweep();
+
+  gcAllocatedBytes = 0;
+  gcThreshold = gcLiveBytes > GC_MIN_THRESHOLD ? gcLiveBytes : GC_MIN_THRESHOLD;
+  if (gcHeapLimit != 0 && gcLiveBytes > gcHeapLimit) {
+    printf("Memory error: heap limit exceeded\n");
+    texit(1);
+  }
+}
+
+void gcPrintStats() {
+  fprintf(stderr, "gc: %zu objects, %zu bytes allocated, %d minor and %d major collections\n",
+          gcObjectsAllocated, gcBytesAllocated, gcMinorCollections,
+          gcMajorCollections);
+}
+
+void gcCollect() {
+  collectMajor();
+}
+
+#ifdef GC_STRESS
+int gcSafePoints;
+#endif
+
+void gcSafePoint() {
+#ifdef GC_STRESS
+  if (++gcSafePoints % 64 == 0) {
+    collectMajor();
+  } else {
+    gcCollectMinor();
+  }
+#else
+  if (gcAllocatedBytes >= gcThreshold) {
+    collectMajor();
+  } else if (gcNurseryFull) {
+    collectMinor();
+  }
+#endif
+}
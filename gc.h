@@ -0,0 +1,84 @@
+#include <stdlib.h>
+#include "value.h"
+
+#ifndef _GC
+#define _GC
+
+// What a heap object holds, which tells the collector how to trace it.
+typedef enum {
+    GC_FREE,    // a dead cell on a free list, or a copied nursery object
+    GC_VALUE,   // a struct Value; traced according to its type
+    GC_FRAME,   // a struct Frame
+    GC_CODE,    // a struct Code; its constants are traced
+    GC_RAW,     // bytes that never point at other heap objects
+} gcKind;
+
+// Allocate a collected object of the given size. New objects start out in the
+// nursery and are moved to the old space if they survive a minor collection,
+// so the memory is only guaranteed to survive, and a pointer to it only stays
+// valid, if it is reachable from a root.
+void *gcAlloc(size_t size, gcKind kind);
+
+// Allocate an object that is never collected or moved, for things that live
+// as long as the interpreter does. It must not point at collected objects.
+void *gcAllocPermanent(size_t size, gcKind kind);
+
+// Allocate a fresh Value on the collected heap.
+Value *gcValue();
+
+// Allocate a Frame with the given number of slots, all empty (NULL).
+Frame *gcFrame(int size);
+
+// Allocate a Code with room for the given number of constants and
+// instructions. The constants start out empty (NULL).
+Code *gcCode(int constantCount, int length);
+
+// Roots are the addresses of C variables holding Value or Frame pointers. The
+// collector reads each variable when it runs, and rewrites it when the object
+// moves, so a protected variable may be reassigned freely. Protect and
+// unprotect in LIFO order.
+extern void ***gcRootStack;
+extern int gcRootTop;
+extern int gcRootCapacity;
+void gcGrowRoots();
+
+#define gcProtect(var) do { \
+    if (gcRootTop == gcRootCapacity) gcGrowRoots(); \
+    gcRootStack[gcRootTop++] = (void **) &(var); \
+  } while (0)
+
+#define gcUnprotect(count) (gcRootTop -= (count))
+
+// Registers a function that finds roots kept somewhere other than a protected
+// variable, such as the VM's stacks. The collector passes it a visit function
+// to call on the address of each heap pointer.
+void gcAddRootTracer(void (*tracer)(void (*visit)(void **)));
+
+// Collections only happen here, never inside gcAlloc, so code that allocates
+// without reaching a safe point does not need to protect its temporaries.
+// Building with -DGC_STRESS collects at every safe point.
+void gcSafePoint();
+
+// Must be called after storing a heap pointer into an object that may already
+// be in the old space, so that a minor collection can find the old-to-young
+// pointer. Freshly allocated objects need no barrier while being filled in.
+void gcWriteBarrier(void *object);
+
+// Run a full collection now.
+void gcCollect();
+
+// Empty the nursery now. Afterwards every reachable object is in the old space
+// and will not move again.
+void gcCollectMinor();
+
+// Prints how many objects and bytes have been allocated on the collected heap,
+// and how many collections have run, to stderr.
+void gcPrintStats();
+extern size_t gcObjectsAllocated;
+extern size_t gcBytesAllocated;
+
+// Cap on live heap bytes; exceeding it after a collection is fatal. Zero
+// means unlimited.
+void gcSetHeapLimit(size_t bytes);
+
+#endif
@@ -0,0 +1,232 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "hashtable.h"
+#include "value.h"
+#include "linkedlist.h"
+#include "vector.h"
+#include "bignum.h"
+#include "gc.h"
+
+// The entries are a vector with key i at element 2i and its value at 2i + 1.
+// Empty slots have a NULL key. Collisions probe linearly, and deleting shifts
+// later entries of the same run back, so there are no tombstones. The vector
+// is kept at most three quarters full and doubles when it gets there.
+#define INITIAL_CAPACITY 8
+
+#define keyAt(entries, i) (elementsOf(entries)[2 * (i)])
+#define valueAt(entries, i) (elementsOf(entries)[2 * (i) + 1])
+#define capacityOf(entries) ((entries)->vector.length / 2)
+
+uint64_t mix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  return h;
+}
+
+uint64_t hashBytes(const unsigned char *bytes, size_t length) {
+  uint64_t h = 14695981039346656037ull;
+  for (size_t i = 0; i < length; i++) {
+    h = (h ^ bytes[i]) * 1099511628211ull;
+  }
+  return h;
+}
+
+// Lists only hash their first few elements, so a long list key costs no more
+// to hash than a short one.
+uint64_t hashValue(Value *key, int depth) {
+  if (isImmediate(key) || typeOf(key) == SYMBOL_TYPE) {
+    return mix((uintptr_t) key);
+  }
+  switch (typeOf(key)) {
+    case DOUBLE_TYPE: {
+      // -0.0 and 0.0 are equal, and so are all NaNs, so each group must hash
+      // the same.
+      double d = key->d == 0 ? 0.0 : isnan(key->d) ? NAN : key->d;
+      return hashBytes((const unsigned char *) &d, sizeof(double));
+    }
+    case BIGNUM_TYPE: {
+      double d = integerToDouble(key);
+      return hashBytes((const unsigned char *) &d, sizeof(double));
+    }
+    case STR_TYPE:
+      return hashBytes((const unsigned char *) key->s, key->length);
+    case CONS_TYPE:
+      if (depth == 0) {
+        return CONS_TYPE;
+      }
+      return mix(hashValue(car(key), depth - 1) * 31 + hashValue(cdr(key), depth - 1));
+    case VECTOR_TYPE:
+    case F64VECTOR_TYPE:
+    case S64VECTOR_TYPE:
+      return mix(((uint64_t) typeOf(key) << 32) + key->vector.length);
+    default:
+      return typeOf(key);
+  }
+}
+
+int equalValues(Value *a, Value *b) {
+  if (a == b) {
+    return 1;
+  } else if (isImmediate(a) || isImmediate(b) || typeOf(a) != typeOf(b)) {
+    return 0;
+  }
+  switch (typeOf(a)) {
+    case DOUBLE_TYPE:
+      return a->d == b->d || (isnan(a->d) && isnan(b->d));
+    case BIGNUM_TYPE:
+      return integerCompare(a, b) == 0;
+    case STR_TYPE:
+      return a->length == b->length && memcmp(a->s, b->s, a->length) == 0;
+    case CONS_TYPE:
+      while (typeOf(a) == CONS_TYPE && typeOf(b) == CONS_TYPE) {
+        if (!equalValues(car(a), car(b))) {
+          return 0;
+        }
+        a = cdr(a);
+        b = cdr(b);
+      }
+      return equalValues(a, b);
+    case VECTOR_TYPE:
+      if (a->vector.length != b->vector.length) {
+        return 0;
+      }
+      for (int i = 0; i < a->vector.length; i++) {
+        if (!equalValues(elementsOf(a)[i], elementsOf(b)[i])) {
+          return 0;
+        }
+      }
+      return 1;
+    case F64VECTOR_TYPE:
+    case S64VECTOR_TYPE:
+      return a->vector.length == b->vector.length &&
+             memcmp(doublesOf(a), doublesOf(b), 8 * a->vector.length) == 0;
+    default:
+      return 0;
+  }
+}
+
+int sameKey(Value *table, Value *a, Value *b) {
+  return a == b || (table->table.equal && equalValues(a, b));
+}
+
+// Returns the slot holding key, or the empty slot where it would go.
+int findSlot(Value *table, Value *entries, Value *key) {
+  int mask = capacityOf(entries) - 1;
+  int slot = hashValue(key, 4) & mask;
+  while (keyAt(entries, slot) != NULL && !sameKey(table, keyAt(entries, slot), key)) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+Value *makeHashTable(int equal) {
+  Value *table = gcValue();
+  table->type = HASHTABLE_TYPE;
+  table->table.count = 0;
+  table->table.equal = equal;
+  table->table.entries = makeVector(2 * INITIAL_CAPACITY, NULL);
+  return table;
+}
+
+void growHashTable(Value *table) {
+  Value *old = table->table.entries;
+  Value *entries = makeVector(4 * capacityOf(old), NULL);
+  for (int i = 0; i < capacityOf(old); i++) {
+    if (keyAt(old, i) != NULL) {
+      int slot = findSlot(table, entries, keyAt(old, i));
+      keyAt(entries, slot) = keyAt(old, i);
+      valueAt(entries, slot) = valueAt(old, i);
+    }
+  }
+  table->table.entries = entries;
+  gcWriteBarrier(table);
+}
+
+Value *hashTableRef(Value *table, Value *key) {
+  Value *entries = table->table.entries;
+  return valueAt(entries, findSlot(table, entries, key));
+}
+
+void hashTableSet(Value *table, Value *key, Value *value) {
+  if (4 * (table->table.count + 1) > 3 * capacityOf(table->table.entries)) {
+    growHashTable(table);
+  }
+  Value *entries = table->table.entries;
+  int slot = findSlot(table, entries, key);
+  if (keyAt(entries, slot) == NULL) {
+    keyAt(entries, slot) = key;
+    table->table.count++;
+  }
+  valueAt(entries, slot) = value;
+  gcWriteBarrier(entries);
+}
+
+int hashTableDelete(Value *table, Value *key) {
+  Value *entries = table->table.entries;
+  int mask = capacityOf(entries) - 1;
+  int hole = findSlot(table, entries, key);
+  if (keyAt(entries, hole) == NULL) {
+    return 0;
+  }
+
+  // Walk the rest of the run, moving back any entry whose probe sequence
+  // passes through the hole, so that lookups never stop short of it.
+  int slot = hole;
+  while (1) {
+    slot = (slot + 1) & mask;
+    if (keyAt(entries, slot) == NULL) {
+      break;
+    }
+    int home = hashValue(keyAt(entries, slot), 4) & mask;
+    if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+      keyAt(entries, hole) = keyAt(entries, slot);
+      valueAt(entries, hole) = valueAt(entries, slot);
+      hole = slot;
+    }
+  }
+  keyAt(entries, hole) = NULL;
+  valueAt(entries, hole) = NULL;
+  table->table.count--;
+  gcWriteBarrier(entries);
+  return 1;
+}
+
+// Builds a list from the entries, with each element made by pick.
+Value *collect(Value *table, Value *(*pick)(Value *, Value *)) {
+  Value *entries = table->table.entries;
+  Value *list = NULL_VALUE;
+  for (int i = capacityOf(entries) - 1; i >= 0; i--) {
+    if (keyAt(entries, i) != NULL) {
+      list = cons(pick(keyAt(entries, i), valueAt(entries, i)), list);
+    }
+  }
+  return list;
+}
+
+Value *pickKey(Value *key, Value *value) {
+  (void) value;
+  return key;
+}
+
+Value *pickValue(Value *key, Value *value) {
+  (void) key;
+  return value;
+}
+
+Value *pickPair(Value *key, Value *value) {
+  return cons(key, value);
+}
+
+Value *hashTableKeys(Value *table) {
+  return collect(table, pickKey);
+}
+
+Value *hashTableValues(Value *table) {
+  return collect(table, pickValue);
+}
+
+Value *hashTableToList(Value *table) {
+  return collect(table, pickPair);
+}
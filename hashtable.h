@@ -0,0 +1,34 @@
+#include "value.h"
+
+#ifndef _HASHTABLE
+#define _HASHTABLE
+
+// Hash tables for user programs. A table compares keys with either eq?,
+// which is identity, or equal?, which compares numbers, strings, lists and
+// vectors by their contents. Keys hash by content either way, except that
+// vectors hash only by length because their elements can change, so a key
+// keeps its hash when the collector moves it.
+//
+// Under equal?, 0.0 and -0.0 are the same key, as they are under =, and so
+// are all NaNs, so that a NaN key can be found again rather than adding a
+// new entry each time it is set.
+
+// Allocates an empty table. equal says whether it compares keys with equal?.
+Value *makeHashTable(int equal);
+
+// Returns the value stored under key, or NULL if there is none.
+Value *hashTableRef(Value *table, Value *key);
+
+// Stores value under key, replacing any value already there.
+void hashTableSet(Value *table, Value *key, Value *value);
+
+// Removes key and its value. Returns whether key was there.
+int hashTableDelete(Value *table, Value *key);
+
+// Returns a new list of the table's keys, of its values, or of (key . value)
+// pairs, in no particular order.
+Value *hashTableKeys(Value *table);
+Value *hashTableValues(Value *table);
+Value *hashTableToList(Value *table);
+
+#endif
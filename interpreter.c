@@ -1,81 +1,164 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
 #include <math.h>
+#include <unistd.h>
 #include "parser.h"
 #include "value.h"
 #include "linkedlist.h"
 #include "tokenizer.h"
 #include "talloc.h"
+#include "gc.h"
+#include "symbol.h"
+#include "resolver.h"
+#include "compiler.h"
+#include "vm.h"
+#include "bignum.h"
+#include "vector.h"
+#include "numvector.h"
+#include "hashtable.h"
+#include "stats.h"
+#include "profile.h"
 #include "interpreter.h"
 
+// Prints a string the way it would be written in a program.
+void printString(Value *string) {
+  putchar('"');
+  for (int i = 0; i < string->length; i++) {
+    char next = string->s[i];
+    if (next == '"' || next == '\\') {
+      putchar('\\');
+    } else if (next == '\n') {
+      putchar('\\');
+      next = 'n';
+    } else if (next == '\t') {
+      putchar('\\');
+      next = 't';
+    }
+    putchar(next);
+  }
+  putchar('"');
+}
+
 void printHelp(Value *hello) {
-  if (hello->type == INT_TYPE) {
-    printf("%i", hello->i);
-  } else if (hello->type == DOUBLE_TYPE) {
+  if (typeOf(hello) == INT_TYPE || typeOf(hello) == BIGNUM_TYPE) {
+    printInteger(hello);
+  } else if (typeOf(hello) == DOUBLE_TYPE) {
     printf("%lf", hello->d);
-  } else if (hello->type == BOOL_TYPE) {
-    if (hello->i == 1) {
+  } else if (typeOf(hello) == BOOL_TYPE) {
+    if (boolOf(hello)) {
       printf("#t");
     } else {
       printf("#f");
     }
-  } else if (hello->type == STR_TYPE) {
-    printf("%s", hello->s);
-  } else if (hello->type == SYMBOL_TYPE) {
+  } else if (typeOf(hello) == STR_TYPE) {
+    printString(hello);
+  } else if (typeOf(hello) == SYMBOL_TYPE) {
     printf("%s", hello->s);
-  } else if (hello->type == NULL_TYPE) {
+  } else if (hello == NULL_VALUE) {
     printf("()");
-  } else if (hello->type == VOID_TYPE) {
-  } else if (hello->type == CLOSURE_TYPE) {
+  } else if (typeOf(hello) == VOID_TYPE) {
+  } else if (typeOf(hello) == CLOSURE_TYPE) {
     printf("#<procedure>");
+  } else if (typeOf(hello) == HASHTABLE_TYPE) {
+    printf("#<hash-table>");
   }
 }
 
 void print(Value *tree) {
-  if (tree->type != CONS_TYPE) {
+  if (typeOf(tree) == VECTOR_TYPE) {
+    printf("#(");
+    for (int i = 0; i < tree->vector.length; i++) {
+      if (i > 0) {
+        printf(" ");
+      }
+      print(elementsOf(tree)[i]);
+    }
+    printf(")");
+  } else if (typeOf(tree) == F64VECTOR_TYPE) {
+    printf("#f64(");
+    for (int i = 0; i < tree->vector.length; i++) {
+      printf(i > 0 ? " %lf" : "%lf", doublesOf(tree)[i]);
+    }
+    printf(")");
+  } else if (typeOf(tree) == S64VECTOR_TYPE) {
+    printf("#s64(");
+    for (int i = 0; i < tree->vector.length; i++) {
+      printf(i > 0 ? " %lld" : "%lld", (long long) int64sOf(tree)[i]);
+    }
+    printf(")");
+  } else if (typeOf(tree) != CONS_TYPE) {
     printHelp(tree);
   } else {
     printf("(");
-      while (tree->type != NULL_TYPE) {
-        if (tree->type == CONS_TYPE && car(tree)->type == CONS_TYPE) {
-          print(car(tree));
-        } else {
-          printHelp(car(tree));
-          if (cdr(tree)->type != NULL_TYPE && cdr(tree)->type != CONS_TYPE) {
-            printf(" . ");
-            printHelp(cdr(tree));
-            break;
-          }
-        }
-        if (cdr(tree)->type != NULL_TYPE) {
-          printf(" ");
-        }
-        tree = cdr(tree);
+    while (typeOf(tree) == CONS_TYPE) {
+      print(car(tree));
+      tree = cdr(tree);
+      if (tree != NULL_VALUE) {
+        printf(" ");
       }
-      printf(")");
+    }
+    if (tree != NULL_VALUE) {
+      printf(". ");
+      printHelp(tree);
+    }
+    printf(")");
   }
 }
 
-void bind(char *name, Value *(*function)(Value *), Frame *frame) {
-  Value *newBinding = makeNull();
-  newBinding->type = PRIMITIVE_TYPE;
-  newBinding->pf = function;
+// The frame top-level forms run in. It has no slots of its own: anything the
+// resolver left as a symbol is a global, and lives in globalTable.
+Frame *globalFrame;
+
+// Open-addressing hash table of global bindings, keyed by interned symbol.
+// Symbols never move, so their addresses hash. The table is kept at most half
+// full, doubles when it gets there, and is a root through traceGlobals.
+typedef struct GlobalBinding {
+  Value *symbol;
+  Value *value;
+} GlobalBinding;
+
+GlobalBinding *globalTable;
+size_t globalCapacity;
+size_t globalCount;
+
+void traceGlobals(void (*visit)(void **)) {
+  for (size_t i = 0; i < globalCapacity; i++) {
+    if (globalTable[i].symbol != NULL) {
+      visit((void **) &globalTable[i].value);
+    }
+  }
+}
 
-  Value *binding = makeNull();
-  binding->type = SYMBOL_TYPE;
-  binding->s = name;
+size_t globalSlot(GlobalBinding *table, size_t capacity, Value *symbol) {
+  size_t slot = (((uintptr_t) symbol >> 4) * 2654435761u) & (capacity - 1);
+  while (table[slot].symbol != NULL && table[slot].symbol != symbol) {
+    slot = (slot + 1) & (capacity - 1);
+  }
+  return slot;
+}
 
-  frame->bindings = cons(cons(binding, newBinding), frame->bindings);
+void growGlobalTable() {
+  size_t capacity = globalCapacity == 0 ? 64 : globalCapacity * 2;
+  GlobalBinding *table = talloc(sizeof(GlobalBinding) * capacity);
+  memset(table, 0, sizeof(GlobalBinding) * capacity);
+  for (size_t i = 0; i < globalCapacity; i++) {
+    if (globalTable[i].symbol != NULL) {
+      table[globalSlot(table, capacity, globalTable[i].symbol)] = globalTable[i];
+    }
+  }
+  globalTable = table;
+  globalCapacity = capacity;
 }
 
 int checkDuplicates(Value *param, Value *paramList) {
-  while (paramList->type != NULL_TYPE) {
+  while (paramList != NULL_VALUE) {
     Value *curr = car(paramList);
-    if (curr->type == CONS_TYPE) {
+    if (typeOf(curr) == CONS_TYPE) {
       curr = car(curr);
     }
-    if (curr->type == SYMBOL_TYPE && !strcmp(param->s, curr->s)) {
+    if (curr == param) {
       return 1;
     }
     paramList = cdr(paramList);
@@ -88,35 +171,56 @@ void evaluationError(char *error) {
   texit(1);
 }
 
-Value *lookUpSymbol(Value *symbol, Frame *frame) {
-  while (frame != NULL) {
-    Value *bindings = frame->bindings;
-    while (bindings->type != NULL_TYPE) {
-      Value *curr = car(bindings);
-      if (!strcmp(car(curr)->s, symbol->s)) {
-        return cdr(curr);
-      }
-      bindings = cdr(bindings);
+Value *lookUpSymbol(Value *symbol) {
+  stats.globalLookups++;
+  if (globalCapacity != 0) {
+    GlobalBinding *binding = &globalTable[globalSlot(globalTable, globalCapacity, symbol)];
+    if (binding->symbol != NULL) {
+      return binding->value;
     }
-    frame = frame->parent;
   }
   evaluationError("lookUpSymbol");
   return NULL;
 }
 
+Frame *frameAt(int depth, Frame *frame) {
+  while (depth > 0) {
+    frame = frame->parent;
+    depth--;
+  }
+  return frame;
+}
+
+Value *lookUpLocal(Value *ref, Frame *frame) {
+  stats.localLookups++;
+  stats.framesWalked += ref->ref.depth;
+  Value *value = frameAt(ref->ref.depth, frame)->slots[ref->ref.slot];
+  if (value == NULL) {
+    evaluationError("lookUpLocal: variable used before it is bound");
+  }
+  return value;
+}
+
+// Special forms whose value is that of an expression in tail position return
+// that expression unevaluated, and eval loops round to evaluate it in place of
+// the form. The let family also hands back, through bodyFrame, the frame to
+// evaluate it in. This way a tail call never grows the C stack.
+
 Value *evalIf(Value *args, Frame *frame) {
   if (length(args) != 3) {
     evaluationError("evalIf: args != 3");
   }
   
+  gcProtect(frame);
   Value *boolean = eval(car(args), frame);
-  if (boolean->type != BOOL_TYPE) {
+  gcUnprotect(1);
+  if (typeOf(boolean) != BOOL_TYPE) {
     evaluationError("evalIf: first arg is not of BOOL_TYPE");
   } else {
-    if (boolean->i == 1) {
-      return eval(car(cdr(args)), frame);
+    if (boolOf(boolean)) {
+      return car(cdr(args));
     } else {
-      return eval(car(cdr(cdr(args))), frame);
+      return car(cdr(cdr(args)));
     }
   }
 
@@ -125,14 +229,16 @@ Value *evalIf(Value *args, Frame *frame) {
 
 
 Value *andOrHelper(Value *tree, int andOr, Frame *frame) {
-	Value *boolean = makeNull();
-	while(tree->type != NULL_TYPE){
+	Value *boolean = NULL_VALUE;
+    gcProtect(frame);
+	while(tree != NULL_VALUE){
 		boolean = eval(car(tree), frame);
-        if (boolean->i == andOr) {
-            return boolean;
+        if ((boolean != FALSE_VALUE) == andOr) {
+            break;
         }
         tree = cdr(tree);
 	}
+    gcUnprotect(1);
     return boolean;
 }
 
@@ -151,181 +257,197 @@ Value *evalOr(Value *tree, Frame *frame) {
 }
 
 
-Value *evalLet(Value *tree, Frame *frame) {
+Value *evalLet(Value *tree, Frame *frame, Frame **bodyFrame) {
   if (length(tree) < 2) {
     evaluationError("evalLet: not enough arguments");
   }
 
   Value *bindings;
-  if (tree->type == CONS_TYPE) {
+  if (typeOf(tree) == CONS_TYPE) {
     bindings = car(tree);
-    if (bindings->type != CONS_TYPE && bindings->type != NULL_TYPE) {
+    if (typeOf(bindings) != CONS_TYPE && bindings != NULL_VALUE) {
       evaluationError("evalLet: invalid arguments");
     }
-  } else if (tree->type == NULL_TYPE) {
-    bindings = makeNull();
+  } else if (tree == NULL_VALUE) {
+    bindings = NULL_VALUE;
   } else {
     evaluationError("evalLet: invalid let");
   }
 
-  Frame *newFrame = talloc(sizeof(Frame));
+  Frame *newFrame = gcFrame(length(bindings));
   newFrame->parent = frame;
-  newFrame->bindings = makeNull();
+  gcProtect(frame);
+  gcProtect(newFrame);
 
-  while (bindings->type != NULL_TYPE) {
+  int slot = 0;
+  while (bindings != NULL_VALUE) {
     Value *binding = car(bindings);
-    if (binding->type != CONS_TYPE) {
+    if (typeOf(binding) != CONS_TYPE) {
       evaluationError("evalLet: invalid let");
     } else if (length(binding) < 2) {
       evaluationError("evalLet: not enough arguments in the binding");
     }
     Value *var = car(binding);
-    if (var->type != SYMBOL_TYPE) {
+    if (typeOf(var) != SYMBOL_TYPE) {
       evaluationError("evalLet: wrong variable type");
     }
     Value *expression = eval(car(cdr(binding)), frame);
-    Value *newBinding = cons(var, expression);
-    newFrame->bindings = cons(newBinding, newFrame->bindings);
+    newFrame->slots[slot] = expression;
+    gcWriteBarrier(newFrame);
+    slot++;
 
     bindings = cdr(bindings);
   }
 
-  while (cdr(cdr(tree))->type != NULL_TYPE) {
-    if (cdr(tree)->type == NULL_TYPE) {
+  while (cdr(cdr(tree)) != NULL_VALUE) {
+    if (cdr(tree) == NULL_VALUE) {
       evaluationError("evalError: empty body");
     }
     eval(car(cdr(tree)), newFrame);
     tree = cdr(tree);
   }
-  return eval(car(cdr(tree)), newFrame);
+  gcUnprotect(2);
+  *bodyFrame = newFrame;
+  return car(cdr(tree));
 }
 
-Value *letStar(Value *tree, Frame *frame) {
+Value *letStar(Value *tree, Frame *frame, Frame **bodyFrame) {
   Value *bindings;
-  if (tree->type == CONS_TYPE) {
+  if (typeOf(tree) == CONS_TYPE) {
     bindings = car(tree);
   }
 
-  while (bindings->type != NULL_TYPE) {
-    Frame *newFrame = talloc(sizeof(Frame));
-    newFrame->parent = frame;
-    newFrame->bindings = makeNull();
-
+  gcProtect(frame);
+  while (bindings != NULL_VALUE) {
     Value *binding = car(bindings);
-    if (binding->type != CONS_TYPE) {
+    if (typeOf(binding) != CONS_TYPE) {
       evaluationError("evalLet: invalid let");
     } else if (length(binding) < 2) {
       evaluationError("evalLet: not enough arguments in the binding");
     }
     Value *var = car(binding);
-    if (var->type != SYMBOL_TYPE) {
+    if (typeOf(var) != SYMBOL_TYPE) {
       evaluationError("evalLet: wrong variable type");
     }
     Value *expression = eval(car(cdr(binding)), frame);
-    Value *newBinding = cons(var, expression);
-    newFrame->bindings = cons(newBinding, newFrame->bindings);
+    Frame *newFrame = gcFrame(1);
+    newFrame->parent = frame;
+    newFrame->slots[0] = expression;
 
     bindings = cdr(bindings);
     frame = newFrame;
   }
 
-  while (cdr(cdr(tree))->type != NULL_TYPE) {
-    if (cdr(tree)->type == NULL_TYPE) {
+  while (cdr(cdr(tree)) != NULL_VALUE) {
+    if (cdr(tree) == NULL_VALUE) {
       evaluationError("evalError: empty body");
     }
     eval(car(cdr(tree)), frame);
     tree = cdr(tree);
   }
-  return eval(car(cdr(tree)), frame);
+  gcUnprotect(1);
+  *bodyFrame = frame;
+  return car(cdr(tree));
 }
 
 Value *evalLetBody(Value *letBody, Frame *letFrame) {
-    if (letBody->type == NULL_TYPE) {
+    if (letBody == NULL_VALUE) {
         evaluationError("no body in let");
         return NULL;
     } else {
-        while (cdr(letBody)->type != NULL_TYPE) {
+        gcProtect(letFrame);
+        while (cdr(letBody) != NULL_VALUE) {
             eval(car(letBody), letFrame);
             letBody = cdr(letBody);
         }
-        return eval(car(letBody), letFrame);
+        gcUnprotect(1);
+        return car(letBody);
     }
 }
 
-Value *letrec(Value *args, Frame *frame) {
-    Value *bindingList = makeNull();
-    Value *letBody = makeNull();
-    if (args->type == CONS_TYPE) {
+Value *letrec(Value *args, Frame *frame, Frame **bodyFrame) {
+    Value *bindingList = NULL_VALUE;
+    Value *letBody = NULL_VALUE;
+    if (typeOf(args) == CONS_TYPE) {
         bindingList = car(args);
         letBody = cdr(args);
     }
-    if (bindingList->type != CONS_TYPE && bindingList->type != NULL_TYPE) {
+    if (typeOf(bindingList) != CONS_TYPE && bindingList != NULL_VALUE) {
         evaluationError("improper variable binding format in letrec");
     }
     
-	Frame *letFrame = talloc(sizeof(Frame));
+	Frame *letFrame = gcFrame(length(bindingList));
     letFrame->parent = frame;
-    letFrame->bindings = makeNull();
 
-	Value *variableList = makeNull();
-	Value *expressionList = makeNull();
-	while(bindingList->type != NULL_TYPE){
+	Value *expressionList = NULL_VALUE;
+  gcProtect(letFrame);
+  gcProtect(expressionList);
+	while(bindingList != NULL_VALUE){
 		Value *binding = car(bindingList);
-		if (binding->type != CONS_TYPE) {
+		if (typeOf(binding) != CONS_TYPE) {
         	evaluationError("improper variable binding format in letrec");
     	} else if (length(binding) != 2) {
         	evaluationError("wrong number of items in letrec binding");
 		}
 		Value *variable = car(binding);
-		if (variable->type != SYMBOL_TYPE) {
+		if (typeOf(variable) != SYMBOL_TYPE) {
 			evaluationError("improper variable type for binding in letrec");
 		}
-		Value *temp1 = cons(variable, variableList);
-		variableList = temp1;
 		Value *expression = eval(car(cdr(binding)), letFrame);
 		Value *temp2 = cons(expression, expressionList);
 		expressionList = temp2;
 		bindingList = cdr(bindingList);
 	}
 
-	while(variableList->type != NULL_TYPE){
-		Value *newBinding = cons(car(variableList), car(expressionList));
-    Value *temp = cons(newBinding, letFrame->bindings);
-    letFrame->bindings = temp;
-		variableList = cdr(variableList);
+    // The values are in reverse binding order.
+    int slot = letFrame->size - 1;
+	while(expressionList != NULL_VALUE){
+    letFrame->slots[slot] = car(expressionList);
+    gcWriteBarrier(letFrame);
 		expressionList = cdr(expressionList);
+    slot--;
 	}
+  gcUnprotect(2);
+  *bodyFrame = letFrame;
 	return evalLetBody(letBody, letFrame);
 }
 
+// The expression a chosen cond clause evaluates to. A clause with no body
+// gives void, as it does on the VM.
+Value *condBody(Value *clause) {
+    if (cdr(clause) == NULL_VALUE) {
+        return VOID_VALUE;
+    }
+    return car(cdr(clause));
+}
+
 Value *evalCond(Value *args, Frame *frame) {
     if (length(args) == 0) {
         evaluationError("no arguments in cond");
     }
-    while (args->type != NULL_TYPE) {
+    while (args != NULL_VALUE) {
         Value *condition = car(car(args));
-        if (condition->type == SYMBOL_TYPE && 
-            !strcmp(condition->s, "else")) {
-            if (cdr(args)->type != NULL_TYPE) {
+        if (typeOf(condition) == SYMBOL_TYPE && condition->syntax == ELSE_SYNTAX) {
+            if (cdr(args) != NULL_VALUE) {
                 evaluationError("else is not last test in cond");
             } 
-            return eval(car(cdr(car(args))), frame);
+            return condBody(car(args));
         }
+        gcProtect(frame);
         condition = eval(condition, frame);
-        if (condition->type != BOOL_TYPE) {
+        gcUnprotect(1);
+        if (typeOf(condition) != BOOL_TYPE) {
             evaluationError("non-boolean condition for if");
-        } else if (condition->i) {
-            return eval(car(cdr(car(args))), frame);
+        } else if (boolOf(condition)) {
+            return condBody(car(args));
         }
         args = cdr(args);
     }
-    Value *voidVal = makeNull();
-    voidVal->type = VOID_TYPE;
-    return voidVal;
+    return VOID_VALUE;
 }
 
 Value *evalQuote(Value *tree) {
-    if (tree->type == NULL_TYPE) {
+    if (tree == NULL_VALUE) {
       evaluationError("evalQuote: more than 1 argument");
     } else if (length(tree) != 1) {
       evaluationError("evalQuote: more than 1 argument");
@@ -333,36 +455,52 @@ Value *evalQuote(Value *tree) {
     return car(tree);
 }
 
+// Binds symbol in the global environment, replacing any earlier definition.
+void defineGlobal(Value *symbol, Value *value) {
+  if (profiling && typeOf(value) == CLOSURE_TYPE) {
+    profileNameCode(value->cl.functionCode, symbol->s);
+  }
+  if (2 * (globalCount + 1) > globalCapacity) {
+    growGlobalTable();
+  }
+  GlobalBinding *binding = &globalTable[globalSlot(globalTable, globalCapacity, symbol)];
+  if (binding->symbol == NULL) {
+    binding->symbol = symbol;
+    globalCount++;
+  }
+  binding->value = value;
+}
+
 Value *evalDefine(Value *tree, Frame *frame) {
-  if (tree->type == NULL_TYPE) {
+  if (tree == NULL_VALUE) {
     evaluationError("evalDefine: empty arguments");
-  } else if (car(tree)->type != SYMBOL_TYPE) {
+  } else if (typeOf(car(tree)) != SYMBOL_TYPE) {
     evaluationError("evalDefine: not a symbol");
-  } else if (cdr(tree)->type == NULL_TYPE || car(cdr(tree))->type == NULL_TYPE) {
+  } else if (cdr(tree) == NULL_VALUE || car(cdr(tree)) == NULL_VALUE) {
     evaluationError("evalDefine: empty body");
   }
-  Value *binding = cons(car(tree), eval(car(cdr(tree)), frame));
-  frame->bindings = cons(binding, frame->bindings);
+  gcProtect(frame);
+  Value *value = eval(car(cdr(tree)), frame);
+  gcUnprotect(1);
+  defineGlobal(car(tree), value);
 
-  Value *temp = talloc(sizeof(Value));
-  temp->type = VOID_TYPE;
-  return temp;
+  return VOID_VALUE;
 }
 
 Value *evalLambda(Value *tree, Frame *frame) {
-  if (tree->type == NULL_TYPE) {
+  if (tree == NULL_VALUE) {
     evaluationError("evalLambda: nothing after lambda");
   } else if (length(tree) != 2) {
     evaluationError("evalLambda: either no params or body");
-  } else if (car(tree)->type == CONS_TYPE && car(car(tree))->type != SYMBOL_TYPE) {
+  } else if (typeOf(car(tree)) == CONS_TYPE && typeOf(car(car(tree))) != SYMBOL_TYPE) {
     evaluationError("evalLambda: params must be symbols");
   }
 
-  Value *closure = makeNull();
+  Value *closure = gcValue();
   closure->type = CLOSURE_TYPE;
   Value *param = car(tree);
-  Value *paramList = makeNull();
-  while (param->type != NULL_TYPE) {
+  Value *paramList = NULL_VALUE;
+  while (param != NULL_VALUE) {
     if (checkDuplicates(car(param), paramList)) {
       evaluationError("evalLambda: multiple parameters of same name");
     }
@@ -372,88 +510,90 @@ Value *evalLambda(Value *tree, Frame *frame) {
   closure->cl.paramNames = paramList;
   closure->cl.functionCode = car(cdr(tree));
   closure->cl.frame = frame;
+  if (profiling) {
+    profileNoteLambda(closure->cl.functionCode, tree);
+  }
 
   return closure;
 }
 
 int setBinding(Value *variable, Value *newVal, Frame *frame){
-    int isBound = 0;
-    do {
-        Value *bindings = frame->bindings;
-        while(bindings->type != NULL_TYPE){
-            Value *binding = car(bindings);
-            if (!strcmp(car(binding)->s, variable->s)) {
-                isBound = 1;
-                binding->c.cdr = newVal;
-                break;
-            }
-            bindings = cdr(bindings);
-        }
-        if (frame->parent != NULL) {
-            frame = frame->parent;
-        } else {
-            break;
-        }  
-    } while (frame->parent != NULL);
-    return isBound;
+    if (typeOf(variable) == LOCAL_TYPE) {
+        frame = frameAt(variable->ref.depth, frame);
+        frame->slots[variable->ref.slot] = newVal;
+        gcWriteBarrier(frame);
+        return 1;
+    }
+
+    if (globalCapacity == 0) {
+        return 0;
+    }
+    GlobalBinding *binding = &globalTable[globalSlot(globalTable, globalCapacity, variable)];
+    if (binding->symbol == NULL) {
+        return 0;
+    }
+    binding->value = newVal;
+    return 1;
 }
 
 Value *set(Value *args, Frame *frame){
-	 if (args->type == NULL_TYPE) {
+	 if (args == NULL_VALUE) {
         evaluationError("no arguments passed to set!");
-    } else if (cdr(args)->type == NULL_TYPE) {
+    } else if (cdr(args) == NULL_VALUE) {
         evaluationError("no value to bind variable to in set!");
-    } else if (car(args)->type != SYMBOL_TYPE) {
+    } else if (typeOf(car(args)) != SYMBOL_TYPE && typeOf(car(args)) != LOCAL_TYPE) {
         evaluationError("non-symbol cannot be bound to a value in set!");
     } 
 	Value *variable = car(args);
+    gcProtect(frame);
 	Value *expression = eval(car(cdr(args)),frame);
+    gcUnprotect(1);
     int varWasSet = setBinding(variable, expression, frame);
     if (!varWasSet) {
         evaluationError("no binding to modify in set!");
     } 
-    Value *voidVal = makeNull();
-    voidVal->type = VOID_TYPE;
-    return voidVal;
+    return VOID_VALUE;
 }
 
 
 Value *begin(Value *tree, Frame *frame) {
-  while (tree->type != NULL_TYPE) {
-        Value *evaluation = eval(car(tree), frame);
-        if (cdr(tree)->type == NULL_TYPE) {
-            return evaluation;
+  gcProtect(frame);
+  while (tree != NULL_VALUE) {
+        if (cdr(tree) == NULL_VALUE) {
+            gcUnprotect(1);
+            return car(tree);
         }
+        eval(car(tree), frame);
 		tree = cdr(tree);
     }
-    Value *voidVal = makeNull();
-    voidVal->type = VOID_TYPE;
-    return voidVal;
+    gcUnprotect(1);
+    return VOID_VALUE;
 }
 
 
-Value *apply(Value *function, Value *args) {
-  if (function->type == CLOSURE_TYPE) {
-    Value *bindings = makeNull();
-    Value *names = function->cl.paramNames;
-    Value *body = function->cl.functionCode;
-    while (args->type != NULL_TYPE && names->type != NULL_TYPE) {
-      Value *binding = cons(car(names), car(args));
-      bindings = cons(binding, bindings);
-      names = cdr(names);
-      args = cdr(args);
-    }
-    if (args->type != NULL_TYPE || names->type != NULL_TYPE) {
-      evaluationError("apply: invalid");
-    }
-
-    Frame *newFrame = talloc(sizeof(Frame));
-    newFrame->bindings = bindings;
-    newFrame->parent = function->cl.frame;
+// Makes the frame a closure's body is evaluated in, with its parameters bound
+// to args.
+Frame *bindArguments(Value *function, Value *args) {
+  int count = length(args);
+  if (count != length(function->cl.paramNames)) {
+    evaluationError("apply: invalid");
+  }
 
-    return eval(body, newFrame);
+  // args is in reverse order, last argument first.
+  Frame *newFrame = gcFrame(count);
+  newFrame->parent = function->cl.frame;
+  for (int slot = count - 1; slot >= 0; slot--) {
+    newFrame->slots[slot] = car(args);
+    args = cdr(args);
+  }
+  return newFrame;
+}
 
-  } else if (function->type == PRIMITIVE_TYPE) {
+// Applies a primitive. Closures are applied by eval itself, so that calls to
+// them in tail position can reuse its C frame.
+Value *apply(Value *function, Value *args) {
+  if (typeOf(function) == PRIMITIVE_TYPE) {
+    stats.primitiveCalls[function->primitive]++;
     return (function->pf)(args);
   } else {
     evaluationError("apply: invalid function");
@@ -461,216 +601,289 @@ Value *apply(Value *function, Value *args) {
   return NULL;
 }
 
-Value *sumHelp(Value *tree) {
-  Value *sum = makeNull();
-  double value = 0;
-  int isDouble = 0;
-
-  while (tree->type != NULL_TYPE) {
-    if (car(tree)->type == DOUBLE_TYPE) {
-      isDouble = 1;
-      value = value + car(tree)->d;
-    } else if (car(tree)->type == INT_TYPE) {
-      value = value + car(tree)->i;
-    } else {
-      evaluationError("sumHelp: not a number");
-    }
-    tree = cdr(tree);
-  }
+Value *makeDouble(double d) {
+  Value *result = gcValue();
+  result->type = DOUBLE_TYPE;
+  result->d = d;
+  return result;
+}
 
-  if (isDouble) {
-    sum->type = DOUBLE_TYPE;
-    sum->d = value;
-    return sum;
+double doubleHelp(Value *value) {
+  double result = 0;
+  if (typeOf(value) == DOUBLE_TYPE) {
+    result = value->d;
+  } else if (isInteger(value)) {
+    result = integerToDouble(value);
   } else {
-    sum->type = INT_TYPE;
-    sum->i = (int) value;
-    return sum;
+    evaluationError("doubleHelp: not a number type");
   }
+
+  return result;
 }
 
-Value *moduloHelp(Value *args) {
-    if (length(args) != 2) {
-        evaluationError("wrong number of args for modulo");
-    } else if (car(args)->type != INT_TYPE ||
-        car(cdr(args))->type != INT_TYPE) {
-        evaluationError("wrong argument type in modulo");
-    } 
-    Value *result = makeNull();
-    result->type = INT_TYPE;
-    result->i = car(cdr(args))->i % car(args)->i;
-	return result;
+void checkNumber(Value *value, char *error) {
+  if (typeOf(value) != DOUBLE_TYPE && !isInteger(value)) {
+    evaluationError(error);
+  }
 }
 
-Value *multiplyHelp(Value *tree) {
-  Value *result = makeNull();
-  double value = 1;
-  int isDouble = 0;
-
-  while (tree->type != NULL_TYPE) {
-    if (car(tree)->type == DOUBLE_TYPE) {
-      isDouble = 1;
-      value =  value * car(tree)->d ;
-    } else if (car(tree)->type == INT_TYPE) {
-      value = value * car(tree)->i;    
-    } else {
-      evaluationError("multiplyHelp: not a number");
-    }
-    tree = cdr(tree);
+// The operand types of a binary arithmetic kernel. Each operation works this
+// out once, and then each case can use its operands directly: two fixnums as
+// machine integers, two doubles as doubles, any other two integers exactly,
+// and anything else by converting to doubles, which rejects non-numbers.
+typedef enum {
+  FIXNUM_PAIR, DOUBLE_PAIR, INTEGER_PAIR, MIXED_PAIR,
+} numberPair;
+
+static inline numberPair pairOf(Value *a, Value *b) {
+  if (isFixnum(a) && isFixnum(b)) {
+    return FIXNUM_PAIR;
+  } else if (typeOf(a) == DOUBLE_TYPE && typeOf(b) == DOUBLE_TYPE) {
+    return DOUBLE_PAIR;
+  } else if (isInteger(a) && isInteger(b)) {
+    return INTEGER_PAIR;
   }
+  return MIXED_PAIR;
+}
 
-  if (isDouble) {
-    result->type = DOUBLE_TYPE;
-    result->d = value;
-    return result;
-  } else {
-    result->type = INT_TYPE;
-    result->i = (int) value;
-    return result;
+Value *addNumbers(Value *a, Value *b) {
+  switch (pairOf(a, b)) {
+    case FIXNUM_PAIR: {
+      // Fixnums have a bit to spare, so this cannot overflow.
+      intptr_t sum = intOf(a) + intOf(b);
+      if (sum >= FIXNUM_MIN && sum <= FIXNUM_MAX) {
+        return makeInt(sum);
+      }
+      return integerAdd(a, b);
+    }
+    case DOUBLE_PAIR:
+      return makeDouble(a->d + b->d);
+    case INTEGER_PAIR:
+      return integerAdd(a, b);
+    default:
+      return makeDouble(doubleHelp(a) + doubleHelp(b));
   }
 }
 
-Value *divideHelp(Value *tree) {
-  Value *result = makeNull();
-  double value = 1;
-  int isDouble = 0;
-
-  while (tree->type != NULL_TYPE) {
-    int temp = (int) value;
-    if (car(tree)->type == DOUBLE_TYPE) {
-      isDouble = 1;
-      value =  car(tree)->d / value;
-    } else if (car(tree)->type == INT_TYPE && car(tree)->i % temp != 0) {
-      isDouble = 1;
-      value =  car(tree)->i / value;
-    } else if (car(tree)->type == INT_TYPE) {
-      value = car(tree)->i / value;
-    } else {
-      evaluationError("divideHelp: not a number");
+Value *subtractNumbers(Value *a, Value *b) {
+  switch (pairOf(a, b)) {
+    case FIXNUM_PAIR: {
+      intptr_t difference = intOf(a) - intOf(b);
+      if (difference >= FIXNUM_MIN && difference <= FIXNUM_MAX) {
+        return makeInt(difference);
+      }
+      return integerSubtract(a, b);
     }
-    tree = cdr(tree);
+    case DOUBLE_PAIR:
+      return makeDouble(a->d - b->d);
+    case INTEGER_PAIR:
+      return integerSubtract(a, b);
+    default:
+      return makeDouble(doubleHelp(a) - doubleHelp(b));
   }
+}
 
-  if (isDouble) {
-    result->type = DOUBLE_TYPE;
-    result->d = value;
-    return result;
-  } else {
-    result->type = INT_TYPE;
-    result->i = (int) value;
-    return result;
+Value *multiplyNumbers(Value *a, Value *b) {
+  switch (pairOf(a, b)) {
+    case FIXNUM_PAIR:
+    case INTEGER_PAIR:
+      return integerMultiply(a, b);
+    case DOUBLE_PAIR:
+      return makeDouble(a->d * b->d);
+    default:
+      return makeDouble(doubleHelp(a) * doubleHelp(b));
   }
 }
 
+// Integers that divide evenly give an integer. Anything else is a double,
+// which for two integers is worked out from the exact quotient and remainder
+// so that it stays accurate when they are too big to convert on their own.
+Value *divideNumbers(Value *a, Value *b) {
+  switch (pairOf(a, b)) {
+    case FIXNUM_PAIR:
+      if (b == makeInt(0)) {
+        evaluationError("divideHelp: division by zero");
+      } else if (intOf(a) % intOf(b) == 0) {
+        return makeInteger(intOf(a) / intOf(b));
+      }
+      return makeDouble((double) intOf(a) / intOf(b));
+    case DOUBLE_PAIR:
+      return makeDouble(a->d / b->d);
+    case INTEGER_PAIR: {
+      if (b == makeInt(0)) {
+        evaluationError("divideHelp: division by zero");
+      }
+      Value *remainder;
+      Value *quotient = integerDivide(a, b, &remainder);
+      if (remainder == makeInt(0)) {
+        return quotient;
+      }
+      return makeDouble(integerToDouble(quotient) +
+                        integerToDouble(remainder) / integerToDouble(b));
+    }
+    default:
+      return makeDouble(doubleHelp(a) / doubleHelp(b));
+  }
+}
 
-double doubleHelp(Value *value) {
-  double result = 0;
-  if (value->type == DOUBLE_TYPE) {
-    result = value->d;
-  } else if (value->type == INT_TYPE) {
-    result = value->i;
-  } else {
-    evaluationError("doubleHelp: not a number type");
+// The comparisons the ordering primitives make.
+typedef enum {
+  LESS, GREATER, EQUAL,
+} comparison;
+
+#define COMPARE(first, second, test) \
+  ((test) == LESS ? (first) < (second) : \
+   (test) == GREATER ? (first) > (second) : (first) == (second))
+
+// Whether a compares with b as test says. Doubles are compared with the
+// operator itself rather than through a three-way result, so that NaN is
+// neither less than, greater than nor equal to anything.
+int compareNumbers(Value *a, Value *b, comparison test) {
+  switch (pairOf(a, b)) {
+    case FIXNUM_PAIR:
+      return COMPARE(intOf(a), intOf(b), test);
+    case DOUBLE_PAIR:
+      return COMPARE(a->d, b->d, test);
+    case INTEGER_PAIR:
+      return COMPARE(integerCompare(a, b), 0, test);
+    default:
+      return COMPARE(doubleHelp(a), doubleHelp(b), test);
   }
+}
 
-  return result;
+// Primitives get their arguments last first, so in each of these the first
+// argument is the last one in tree. The two-argument case, which is nearly
+// every call, goes straight to a kernel without walking the list.
+static inline int twoArguments(Value *tree) {
+  return tree != NULL_VALUE && cdr(tree) != NULL_VALUE &&
+         cdr(cdr(tree)) == NULL_VALUE;
 }
 
-Value *subtractHelp(Value *tree) {
-  Value *result = makeNull();
-  double value = 0;
-  int isDouble = 0;
-
-  while (tree->type != NULL_TYPE) {
-    if (car(tree)->type == DOUBLE_TYPE) {
-      isDouble = 1;
-      value = car(tree)->d - value;
-    } else if (car(tree)->type == INT_TYPE) {
-      value = car(tree)->i - value;
-    } else {
-      evaluationError("subtractHelp: not a number");
-    }
-    tree = cdr(tree);
+Value *sumHelp(Value *tree) {
+  if (twoArguments(tree)) {
+    return addNumbers(car(cdr(tree)), car(tree));
   }
+  Value *value = makeInt(0);
 
-  if (isDouble) {
-    result->type = DOUBLE_TYPE;
-    result->d = value;
-    return result;
-  } else {
-    result->type = INT_TYPE;
-    result->i = (int) value;
-    return result;
+  while (tree != NULL_VALUE) {
+    checkNumber(car(tree), "sumHelp: not a number");
+    value = addNumbers(car(tree), value);
+    tree = cdr(tree);
   }
+  return value;
 }
 
-Value *lessHelp(Value *tree) { 
-  Value *result = makeNull();
-  result->type = BOOL_TYPE;
-  
-  double first = doubleHelp(car(tree));
-  double second = doubleHelp(car(cdr(tree)));
+Value *moduloHelp(Value *args) {
+    if (length(args) != 2) {
+        evaluationError("wrong number of args for modulo");
+    } else if (!isInteger(car(args)) || !isInteger(car(cdr(args)))) {
+        evaluationError("wrong argument type in modulo");
+    } else if (car(args) == makeInt(0)) {
+        evaluationError("modulo: division by zero");
+    }
+    Value *remainder;
+    integerDivide(car(cdr(args)), car(args), &remainder);
+    return remainder;
+}
 
-  if (first > second) {
-    result->i = 1;
-  } else {
-    result->i = 0;
+Value *multiplyHelp(Value *tree) {
+  if (twoArguments(tree)) {
+    return multiplyNumbers(car(cdr(tree)), car(tree));
   }
+  Value *value = makeInt(1);
 
-  return result;
+  while (tree != NULL_VALUE) {
+    checkNumber(car(tree), "multiplyHelp: not a number");
+    value = multiplyNumbers(car(tree), value);
+    tree = cdr(tree);
+  }
+  return value;
 }
 
-Value *greaterHelp(Value *tree) {
-  Value *result = makeNull();
-  result->type = BOOL_TYPE;
-  
-  double first = doubleHelp(car(tree));
-  double second = doubleHelp(car(cdr(tree)));
+// The first argument divided by the product of the rest, or inverted if it is
+// alone.
+Value *divideHelp(Value *tree) {
+  if (twoArguments(tree)) {
+    return divideNumbers(car(cdr(tree)), car(tree));
+  } else if (tree == NULL_VALUE) {
+    evaluationError("divideHelp: no arguments");
+  }
+  Value *divisor = makeInt(1);
+  Value *args = tree;
+  while (cdr(tree) != NULL_VALUE) {
+    checkNumber(car(tree), "divideHelp: not a number");
+    divisor = multiplyNumbers(car(tree), divisor);
+    tree = cdr(tree);
+  }
+  checkNumber(car(tree), "divideHelp: not a number");
+  if (tree == args) {
+    return divideNumbers(makeInt(1), car(tree));
+  }
+  return divideNumbers(car(tree), divisor);
+}
 
-  if (first < second) {
-    result->i = 1;
-  } else {
-    result->i = 0;
+// The first argument minus the sum of the rest, or negated if it is alone.
+Value *subtractHelp(Value *tree) {
+  if (twoArguments(tree)) {
+    return subtractNumbers(car(cdr(tree)), car(tree));
+  } else if (tree == NULL_VALUE) {
+    evaluationError("subtractHelp: no arguments");
+  }
+  Value *subtrahend = makeInt(0);
+  Value *args = tree;
+  while (cdr(tree) != NULL_VALUE) {
+    checkNumber(car(tree), "subtractHelp: not a number");
+    subtrahend = addNumbers(car(tree), subtrahend);
+    tree = cdr(tree);
   }
+  checkNumber(car(tree), "subtractHelp: not a number");
+  if (tree == args) {
+    return subtractNumbers(makeInt(0), car(tree));
+  }
+  return subtractNumbers(car(tree), subtrahend);
+}
 
-  return result;
+// Whether each argument compares with the one after it as test says, the
+// way (< a b c) means a < b and b < c.
+Value *compareChain(Value *tree, comparison test, char *error) {
+  if (twoArguments(tree)) {
+    return makeBool(compareNumbers(car(cdr(tree)), car(tree), test));
+  } else if (tree == NULL_VALUE) {
+    evaluationError(error);
+  }
+  checkNumber(car(tree), error);
+  while (cdr(tree) != NULL_VALUE) {
+    if (!compareNumbers(car(cdr(tree)), car(tree), test)) {
+      return FALSE_VALUE;
+    }
+    tree = cdr(tree);
+  }
+  return TRUE_VALUE;
 }
 
-Value *equalHelp(Value *tree) {
-  Value *result = makeNull();
-  result->type = BOOL_TYPE;
-  
-  double first = doubleHelp(car(tree));
-  double second = doubleHelp(car(cdr(tree)));
+Value *lessHelp(Value *tree) {
+  return compareChain(tree, LESS, "lessHelp: not a number");
+}
 
-  if (first == second) {
-    result->i = 1;
-  } else {
-    result->i = 0;
-  }
+Value *greaterHelp(Value *tree) {
+  return compareChain(tree, GREATER, "greaterHelp: not a number");
+}
 
-  return result;
+Value *equalHelp(Value *tree) {
+  return compareChain(tree, EQUAL, "equalHelp: not a number");
 }
 
 Value *nullHelp(Value *arg) {
   if (length(arg) != 1) {
     evaluationError("nullHelp: invalid length");
   }
-  Value *boolean = makeNull();
-  boolean->type = BOOL_TYPE;
-  
-  if (car(arg)->type == NULL_TYPE) {
-    boolean->i = 1;
-  } else {
-    boolean->i = 0;
-  }
-  return boolean;
+  return makeBool(car(arg) == NULL_VALUE);
 }
 
 Value *carHelp(Value *arg) {
   if (length(arg) != 1) {
     evaluationError("carHelp: invalid length");
-  } else if (car(arg)->type != CONS_TYPE) {
+  } else if (typeOf(car(arg)) != CONS_TYPE) {
     evaluationError("carHelp: not of CONS type");
   }
   return car(car(arg));
@@ -679,7 +892,7 @@ Value *carHelp(Value *arg) {
 Value *cdrHelp(Value *arg) {
   if (length(arg) != 1) {
     evaluationError("cdrHelp: invalid length");
-  } else if (car(arg)->type != CONS_TYPE) {
+  } else if (typeOf(car(arg)) != CONS_TYPE) {
     evaluationError("carHelp: not of CONS type");
   }
   return cdr(car(arg));
@@ -692,99 +905,778 @@ Value *consHelp(Value *tree) {
   return cons(car(cdr(tree)), car(tree));
 }
 
-Value *eval(Value *tree, Frame *frame) {
-  if (tree == NULL) {
-    evaluationError("eval: NULL tree");
+// Checks that index is a fixnum that indexes vector, and returns it as an int.
+int vectorIndex(Value *vector, Value *index, char *error) {
+  if (!isFixnum(index) || intOf(index) < 0 ||
+      intOf(index) >= vector->vector.length) {
+    evaluationError(error);
   }
-  switch (tree->type) {
-    case INT_TYPE: {
-      return tree;
-    }
-    case DOUBLE_TYPE: {
-      return tree;
-    }
-    case STR_TYPE: {
-      return tree;
+  return (int) intOf(index);
+}
+
+// Checks that size is a fixnum that can be the length of a vector, and
+// returns it as an int.
+int vectorSize(Value *size, char *error) {
+  if (!isFixnum(size) || intOf(size) < 0 || intOf(size) > INT32_MAX) {
+    evaluationError(error);
+  }
+  return (int) intOf(size);
+}
+
+Value *makeVectorHelp(Value *args) {
+  int count = length(args);
+  if (count != 1 && count != 2) {
+    evaluationError("makeVectorHelp: invalid length");
+  }
+  int size = vectorSize(count == 2 ? car(cdr(args)) : car(args),
+                        "makeVectorHelp: invalid size");
+  return makeVector(size, count == 2 ? car(args) : makeInt(0));
+}
+
+Value *vectorHelp(Value *args) {
+  Value *vector = makeVector(length(args), NULL_VALUE);
+  // The arguments arrive last first, so fill the vector from the back.
+  for (int i = vector->vector.length - 1; i >= 0; i--) {
+    elementsOf(vector)[i] = car(args);
+    args = cdr(args);
+  }
+  return vector;
+}
+
+Value *vectorRefHelp(Value *args) {
+  if (length(args) != 2) {
+    evaluationError("vectorRefHelp: invalid length");
+  }
+  Value *vector = car(cdr(args));
+  if (typeOf(vector) != VECTOR_TYPE) {
+    evaluationError("vectorRefHelp: not a vector");
+  }
+  return elementsOf(vector)[vectorIndex(vector, car(args),
+                                        "vectorRefHelp: index out of range")];
+}
+
+Value *vectorSetHelp(Value *args) {
+  if (length(args) != 3) {
+    evaluationError("vectorSetHelp: invalid length");
+  }
+  Value *vector = car(cdr(cdr(args)));
+  if (typeOf(vector) != VECTOR_TYPE) {
+    evaluationError("vectorSetHelp: not a vector");
+  }
+  int index = vectorIndex(vector, car(cdr(args)),
+                          "vectorSetHelp: index out of range");
+  elementsOf(vector)[index] = car(args);
+  gcWriteBarrier(vector);
+  return VOID_VALUE;
+}
+
+Value *vectorLengthHelp(Value *args) {
+  if (length(args) != 1) {
+    evaluationError("vectorLengthHelp: invalid length");
+  } else if (typeOf(car(args)) != VECTOR_TYPE) {
+    evaluationError("vectorLengthHelp: not a vector");
+  }
+  return makeInt(car(args)->vector.length);
+}
+
+Value *vectorFillHelp(Value *args) {
+  if (length(args) != 2) {
+    evaluationError("vectorFillHelp: invalid length");
+  }
+  Value *vector = car(cdr(args));
+  if (typeOf(vector) != VECTOR_TYPE) {
+    evaluationError("vectorFillHelp: not a vector");
+  }
+  for (int i = 0; i < vector->vector.length; i++) {
+    elementsOf(vector)[i] = car(args);
+  }
+  gcWriteBarrier(vector);
+  return VOID_VALUE;
+}
+
+Value *listToVectorHelp(Value *args) {
+  if (length(args) != 1) {
+    evaluationError("listToVectorHelp: invalid length");
+  }
+  Value *vector = listToVector(car(args));
+  if (vector == NULL) {
+    evaluationError("listToVectorHelp: not a list");
+  }
+  return vector;
+}
+
+Value *vectorToListHelp(Value *args) {
+  if (length(args) != 1) {
+    evaluationError("vectorToListHelp: invalid length");
+  } else if (typeOf(car(args)) != VECTOR_TYPE) {
+    evaluationError("vectorToListHelp: not a vector");
+  }
+  return vectorToList(car(args));
+}
+
+// f64vectors and s64vectors hold their numbers unboxed, so elements are
+// converted on the way in and boxed again on the way out.
+
+int64_t int64Help(Value *value, char *error) {
+  int64_t result;
+  if (!isInteger(value) || !integerToInt64(value, &result)) {
+    evaluationError(error);
+  }
+  return result;
+}
+
+// Checks a primitive's argument count, and that its first argument, which is
+// the last in args, is a vector of the given type. Returns that vector.
+Value *numberVectorArgs(Value *args, int count, valueType type, char *error) {
+  if (length(args) != count) {
+    evaluationError(error);
+  }
+  for (int i = 1; i < count; i++) {
+    args = cdr(args);
+  }
+  if (typeOf(car(args)) != type) {
+    evaluationError(error);
+  }
+  return car(args);
+}
+
+Value *makeF64VectorHelp(Value *args) {
+  int count = length(args);
+  if (count != 1 && count != 2) {
+    evaluationError("makeF64VectorHelp: invalid length");
+  }
+  int size = vectorSize(count == 2 ? car(cdr(args)) : car(args),
+                        "makeF64VectorHelp: invalid size");
+  double fill = count == 2 ? doubleHelp(car(args)) : 0;
+  Value *vector = makeF64Vector(size);
+  for (int i = 0; i < size; i++) {
+    doublesOf(vector)[i] = fill;
+  }
+  return vector;
+}
+
+Value *makeS64VectorHelp(Value *args) {
+  int count = length(args);
+  if (count != 1 && count != 2) {
+    evaluationError("makeS64VectorHelp: invalid length");
+  }
+  int size = vectorSize(count == 2 ? car(cdr(args)) : car(args),
+                        "makeS64VectorHelp: invalid size");
+  int64_t fill = count == 2 ? int64Help(car(args), "makeS64VectorHelp: not a 64-bit integer") : 0;
+  Value *vector = makeS64Vector(size);
+  for (int i = 0; i < size; i++) {
+    int64sOf(vector)[i] = fill;
+  }
+  return vector;
+}
+
+Value *f64VectorHelp(Value *args) {
+  Value *vector = makeF64Vector(length(args));
+  for (int i = vector->vector.length - 1; i >= 0; i--) {
+    doublesOf(vector)[i] = doubleHelp(car(args));
+    args = cdr(args);
+  }
+  return vector;
+}
+
+Value *s64VectorHelp(Value *args) {
+  Value *vector = makeS64Vector(length(args));
+  for (int i = vector->vector.length - 1; i >= 0; i--) {
+    int64sOf(vector)[i] = int64Help(car(args), "s64VectorHelp: not a 64-bit integer");
+    args = cdr(args);
+  }
+  return vector;
+}
+
+Value *f64VectorRefHelp(Value *args) {
+  Value *vector = numberVectorArgs(args, 2, F64VECTOR_TYPE, "f64VectorRefHelp: invalid arguments");
+  return makeDouble(doublesOf(vector)[vectorIndex(vector, car(args), "f64VectorRefHelp: index out of range")]);
+}
+
+Value *s64VectorRefHelp(Value *args) {
+  Value *vector = numberVectorArgs(args, 2, S64VECTOR_TYPE, "s64VectorRefHelp: invalid arguments");
+  return makeInteger(int64sOf(vector)[vectorIndex(vector, car(args), "s64VectorRefHelp: index out of range")]);
+}
+
+Value *f64VectorSetHelp(Value *args) {
+  Value *vector = numberVectorArgs(args, 3, F64VECTOR_TYPE, "f64VectorSetHelp: invalid arguments");
+  int index = vectorIndex(vector, car(cdr(args)), "f64VectorSetHelp: index out of range");
+  doublesOf(vector)[index] = doubleHelp(car(args));
+  return VOID_VALUE;
+}
+
+Value *s64VectorSetHelp(Value *args) {
+  Value *vector = numberVectorArgs(args, 3, S64VECTOR_TYPE, "s64VectorSetHelp: invalid arguments");
+  int index = vectorIndex(vector, car(cdr(args)), "s64VectorSetHelp: index out of range");
+  int64sOf(vector)[index] = int64Help(car(args), "s64VectorSetHelp: not a 64-bit integer");
+  return VOID_VALUE;
+}
+
+Value *f64VectorLengthHelp(Value *args) {
+  Value *vector = numberVectorArgs(args, 1, F64VECTOR_TYPE, "f64VectorLengthHelp: invalid arguments");
+  return makeInt(vector->vector.length);
+}
+
+Value *s64VectorLengthHelp(Value *args) {
+  Value *vector = numberVectorArgs(args, 1, S64VECTOR_TYPE, "s64VectorLengthHelp: invalid arguments");
+  return makeInt(vector->vector.length);
+}
+
+// Applies an elementwise kernel to two f64vectors of the same length, giving
+// a new one.
+Value *f64Elementwise(Value *args, void (*kernel)(double *, const double *, const double *, int), char *error) {
+  Value *a = numberVectorArgs(args, 2, F64VECTOR_TYPE, error);
+  Value *b = car(args);
+  if (typeOf(b) != F64VECTOR_TYPE || b->vector.length != a->vector.length) {
+    evaluationError(error);
+  }
+  Value *result = makeF64Vector(a->vector.length);
+  kernel(doublesOf(result), doublesOf(a), doublesOf(b), a->vector.length);
+  return result;
+}
+
+Value *f64AddHelp(Value *args) {
+  return f64Elementwise(args, f64Add, "f64AddHelp: invalid arguments");
+}
+
+Value *f64MultiplyHelp(Value *args) {
+  return f64Elementwise(args, f64Multiply, "f64MultiplyHelp: invalid arguments");
+}
+
+Value *f64ScaleHelp(Value *args) {
+  Value *vector = numberVectorArgs(args, 2, F64VECTOR_TYPE, "f64ScaleHelp: invalid arguments");
+  double factor = doubleHelp(car(args));
+  Value *result = makeF64Vector(vector->vector.length);
+  f64Scale(doublesOf(result), doublesOf(vector), factor, vector->vector.length);
+  return result;
+}
+
+Value *f64DotHelp(Value *args) {
+  Value *a = numberVectorArgs(args, 2, F64VECTOR_TYPE, "f64DotHelp: invalid arguments");
+  Value *b = car(args);
+  if (typeOf(b) != F64VECTOR_TYPE || b->vector.length != a->vector.length) {
+    evaluationError("f64DotHelp: invalid arguments");
+  }
+  return makeDouble(f64Dot(doublesOf(a), doublesOf(b), a->vector.length));
+}
+
+Value *f64SumHelp(Value *args) {
+  Value *vector = numberVectorArgs(args, 1, F64VECTOR_TYPE, "f64SumHelp: invalid arguments");
+  return makeDouble(f64Sum(doublesOf(vector), vector->vector.length));
+}
+
+Value *f64MinHelp(Value *args) {
+  Value *vector = numberVectorArgs(args, 1, F64VECTOR_TYPE, "f64MinHelp: invalid arguments");
+  if (vector->vector.length == 0) {
+    evaluationError("f64MinHelp: empty vector");
+  }
+  return makeDouble(f64Min(doublesOf(vector), vector->vector.length));
+}
+
+Value *f64MaxHelp(Value *args) {
+  Value *vector = numberVectorArgs(args, 1, F64VECTOR_TYPE, "f64MaxHelp: invalid arguments");
+  if (vector->vector.length == 0) {
+    evaluationError("f64MaxHelp: empty vector");
+  }
+  return makeDouble(f64Max(doublesOf(vector), vector->vector.length));
+}
+
+// Sums in an int64_t for as long as that does not overflow, and folds each
+// partial sum that would into an exact total.
+Value *s64SumHelp(Value *args) {
+  Value *vector = numberVectorArgs(args, 1, S64VECTOR_TYPE, "s64SumHelp: invalid arguments");
+  Value *total = makeInt(0);
+  int64_t sum = 0;
+  for (int i = 0; i < vector->vector.length; i++) {
+    int64_t next = int64sOf(vector)[i];
+    if ((next > 0 && sum > INT64_MAX - next) ||
+        (next < 0 && sum < INT64_MIN - next)) {
+      total = integerAdd(total, makeInteger(sum));
+      sum = 0;
     }
-    case BOOL_TYPE: {
-      return tree;
+    sum += next;
+  }
+  return integerAdd(total, makeInteger(sum));
+}
+
+// Applies an elementwise kernel to two s64vectors of the same length, giving
+// a new one. A result that does not fit in 64 bits is an error.
+Value *s64Elementwise(Value *args, int (*kernel)(int64_t *, const int64_t *, const int64_t *, int), char *error) {
+  Value *a = numberVectorArgs(args, 2, S64VECTOR_TYPE, error);
+  Value *b = car(args);
+  if (typeOf(b) != S64VECTOR_TYPE || b->vector.length != a->vector.length) {
+    evaluationError(error);
+  }
+  Value *result = makeS64Vector(a->vector.length);
+  if (kernel(int64sOf(result), int64sOf(a), int64sOf(b), a->vector.length)) {
+    evaluationError(error);
+  }
+  return result;
+}
+
+Value *s64AddHelp(Value *args) {
+  return s64Elementwise(args, s64Add, "s64AddHelp: invalid arguments or overflow");
+}
+
+Value *s64MultiplyHelp(Value *args) {
+  return s64Elementwise(args, s64Multiply, "s64MultiplyHelp: invalid arguments or overflow");
+}
+
+Value *s64ScaleHelp(Value *args) {
+  Value *vector = numberVectorArgs(args, 2, S64VECTOR_TYPE, "s64ScaleHelp: invalid arguments");
+  int64_t factor = int64Help(car(args), "s64ScaleHelp: not a 64-bit integer");
+  Value *result = makeS64Vector(vector->vector.length);
+  if (s64Scale(int64sOf(result), int64sOf(vector), factor, vector->vector.length)) {
+    evaluationError("s64ScaleHelp: overflow");
+  }
+  return result;
+}
+
+// Like s64SumHelp, accumulates in an int64_t while the products and their
+// sum fit, and folds into an exact total when one would not.
+Value *s64DotHelp(Value *args) {
+  Value *a = numberVectorArgs(args, 2, S64VECTOR_TYPE, "s64DotHelp: invalid arguments");
+  Value *b = car(args);
+  if (typeOf(b) != S64VECTOR_TYPE || b->vector.length != a->vector.length) {
+    evaluationError("s64DotHelp: invalid arguments");
+  }
+  Value *total = makeInt(0);
+  int64_t sum = 0;
+  for (int i = 0; i < a->vector.length; i++) {
+    int64_t x = int64sOf(a)[i];
+    int64_t y = int64sOf(b)[i];
+    int64_t product;
+    int64_t next;
+    if (__builtin_mul_overflow(x, y, &product)) {
+      total = integerAdd(total, integerMultiply(makeInteger(x), makeInteger(y)));
+    } else if (__builtin_add_overflow(sum, product, &next)) {
+      total = integerAdd(total, makeInteger(sum));
+      sum = product;
+    } else {
+      sum = next;
     }
-    case SYMBOL_TYPE: {
-      return lookUpSymbol(tree, frame);
+  }
+  return integerAdd(total, makeInteger(sum));
+}
+
+Value *s64MinHelp(Value *args) {
+  Value *vector = numberVectorArgs(args, 1, S64VECTOR_TYPE, "s64MinHelp: invalid arguments");
+  if (vector->vector.length == 0) {
+    evaluationError("s64MinHelp: empty vector");
+  }
+  return makeInteger(s64Min(int64sOf(vector), vector->vector.length));
+}
+
+Value *s64MaxHelp(Value *args) {
+  Value *vector = numberVectorArgs(args, 1, S64VECTOR_TYPE, "s64MaxHelp: invalid arguments");
+  if (vector->vector.length == 0) {
+    evaluationError("s64MaxHelp: empty vector");
+  }
+  return makeInteger(s64Max(int64sOf(vector), vector->vector.length));
+}
+
+// (make-hash-table) compares keys with equal?, and (make-hash-table 'eq?)
+// with eq?.
+Value *makeHashTableHelp(Value *args) {
+  if (args == NULL_VALUE) {
+    return makeHashTable(1);
+  } else if (length(args) == 1 && typeOf(car(args)) == SYMBOL_TYPE) {
+    if (!strcmp(car(args)->s, "eq?")) {
+      return makeHashTable(0);
+    } else if (!strcmp(car(args)->s, "equal?")) {
+      return makeHashTable(1);
     }
-    case NULL_TYPE: {
-      return tree;
+  }
+  evaluationError("makeHashTableHelp: invalid arguments");
+  return NULL;
+}
+
+// Checks a primitive's argument count, and that its first argument, which is
+// the last in args, is a hash table. Returns the table.
+Value *hashTableArgs(Value *args, int count, char *error) {
+  if (length(args) != count) {
+    evaluationError(error);
+  }
+  for (int i = 1; i < count; i++) {
+    args = cdr(args);
+  }
+  if (typeOf(car(args)) != HASHTABLE_TYPE) {
+    evaluationError(error);
+  }
+  return car(args);
+}
+
+Value *hashTableSetHelp(Value *args) {
+  Value *table = hashTableArgs(args, 3, "hashTableSetHelp: invalid arguments");
+  hashTableSet(table, car(cdr(args)), car(args));
+  return VOID_VALUE;
+}
+
+// (hash-table-ref table key default) gives default when key is missing.
+// Without a default, a missing key is an error.
+Value *hashTableRefHelp(Value *args) {
+  int count = length(args);
+  if (count != 2 && count != 3) {
+    evaluationError("hashTableRefHelp: invalid arguments");
+  }
+  Value *table = hashTableArgs(args, count, "hashTableRefHelp: invalid arguments");
+  Value *value = hashTableRef(table, count == 3 ? car(cdr(args)) : car(args));
+  if (value == NULL) {
+    if (count == 2) {
+      evaluationError("hashTableRefHelp: no such key");
     }
-    case CONS_TYPE: {
-      Value *result = makeNull();
-      Value *first = car(tree);
-      Value *args = cdr(tree);
+    value = car(args);
+  }
+  return value;
+}
+
+Value *hashTableContainsHelp(Value *args) {
+  Value *table = hashTableArgs(args, 2, "hashTableContainsHelp: invalid arguments");
+  return makeBool(hashTableRef(table, car(args)) != NULL);
+}
+
+Value *hashTableDeleteHelp(Value *args) {
+  Value *table = hashTableArgs(args, 2, "hashTableDeleteHelp: invalid arguments");
+  hashTableDelete(table, car(args));
+  return VOID_VALUE;
+}
+
+Value *hashTableCountHelp(Value *args) {
+  Value *table = hashTableArgs(args, 1, "hashTableCountHelp: invalid arguments");
+  return makeInt(table->table.count);
+}
+
+Value *hashTableKeysHelp(Value *args) {
+  return hashTableKeys(hashTableArgs(args, 1, "hashTableKeysHelp: invalid arguments"));
+}
 
-      if (!strcmp(first->s, "if")) {
-          result = evalIf(args, frame);
-      } else if (!strcmp(first->s, "let")) {
-        if (car(cdr(tree))->type == NULL_TYPE) {
-          return eval(car(cdr(cdr(tree))), frame);
+Value *hashTableValuesHelp(Value *args) {
+  return hashTableValues(hashTableArgs(args, 1, "hashTableValuesHelp: invalid arguments"));
+}
+
+Value *hashTableToListHelp(Value *args) {
+  return hashTableToList(hashTableArgs(args, 1, "hashTableToListHelp: invalid arguments"));
+}
+
+Value *eval(Value *tree, Frame *frame) {
+  if (tree == NULL) {
+    evaluationError("eval: NULL tree");
+  }
+  gcProtect(tree);
+  gcProtect(frame);
+  int profileBase = profileDepth;
+
+  // Each time round, either produce the result or replace tree and frame with
+  // the expression in tail position and the frame it is evaluated in.
+  Value *result = NULL;
+  while (result == NULL) {
+    gcSafePoint();
+    stats.evalSteps++;
+
+    switch (typeOf(tree)) {
+      case INT_TYPE: {
+        result = tree;
+        break;
+      }
+      case DOUBLE_TYPE:
+      case BIGNUM_TYPE:
+      case VECTOR_TYPE: {
+        result = tree;
+        break;
+      }
+      case STR_TYPE: {
+        result = tree;
+        break;
+      }
+      case BOOL_TYPE: {
+        result = tree;
+        break;
+      }
+      case SYMBOL_TYPE: {
+        result = lookUpSymbol(tree);
+        break;
+      }
+      case LOCAL_TYPE: {
+        result = lookUpLocal(tree, frame);
+        break;
+      }
+      case NULL_TYPE: {
+        result = tree;
+        break;
+      }
+      case VOID_TYPE: {
+        result = tree;
+        break;
+      }
+      case CONS_TYPE: {
+        Value *first = car(tree);
+        Value *args = cdr(tree);
+
+        syntaxType syntax = NO_SYNTAX;
+        if (typeOf(first) == SYMBOL_TYPE) {
+          syntax = first->syntax;
         }
-          result = evalLet(args, frame);
-      } else if (!strcmp(first->s, "quote")) {
-          result = evalQuote(args);
-      } else if (!strcmp(first->s, "define")) {
-          result = evalDefine(args, frame);
-      } else if (!strcmp(first->s, "lambda")) {
-          result = evalLambda(args, frame);
-      } else if (!strcmp(first->s, "let*")) {
-          result = letStar(args, frame);
-      } else if (!strcmp(first->s, "letrec")) {
-          result = letrec(args, frame);
-      } else if (!strcmp(first->s, "cond")) {
-          result = evalCond(args, frame);
-      } else if (!strcmp(first->s, "set!")) {
-          result = set(args, frame);
-      } else if (!strcmp(first->s, "begin")) {
-          result = begin(args, frame);
-      } else if (!strcmp(first->s, "and")) {
-          result = evalAnd(args, frame);
-      } else if (!strcmp(first->s, "or")) {
-          result = evalOr(args, frame);
-      } else {
-        Value *newArgs = makeNull();
-        while (args->type != NULL_TYPE) {
-          newArgs = cons(eval(car(args), frame), newArgs);
-          args = cdr(args);
+        stats.forms[syntax]++;
+
+        switch (syntax) {
+          case IF_SYNTAX:
+            tree = evalIf(args, frame);
+            break;
+          case LET_SYNTAX:
+            if (args != NULL_VALUE && car(args) == NULL_VALUE) {
+              // (let () ...) has no frame of its own; see the resolver.
+              tree = evalLetBody(cdr(args), frame);
+            } else {
+              tree = evalLet(args, frame, &frame);
+            }
+            break;
+          case QUOTE_SYNTAX:
+            result = evalQuote(args);
+            break;
+          case DEFINE_SYNTAX:
+            result = evalDefine(args, frame);
+            break;
+          case LAMBDA_SYNTAX:
+            result = evalLambda(args, frame);
+            break;
+          case LET_STAR_SYNTAX:
+            tree = letStar(args, frame, &frame);
+            break;
+          case LETREC_SYNTAX:
+            tree = letrec(args, frame, &frame);
+            break;
+          case COND_SYNTAX:
+            tree = evalCond(args, frame);
+            break;
+          case SET_SYNTAX:
+            result = set(args, frame);
+            break;
+          case BEGIN_SYNTAX:
+            tree = begin(args, frame);
+            break;
+          case AND_SYNTAX:
+            result = evalAnd(args, frame);
+            break;
+          case OR_SYNTAX:
+            result = evalOr(args, frame);
+            break;
+          default: {
+            // The arguments evaluated so far are only reachable from here.
+            Value *newArgs = NULL_VALUE;
+            gcProtect(newArgs);
+            while (args != NULL_VALUE) {
+              Value *arg = eval(car(args), frame);
+              newArgs = cons(arg, newArgs);
+              args = cdr(args);
+            }
+            first = eval(first, frame);
+            if (typeOf(first) == CLOSURE_TYPE) {
+              stats.closureApplications++;
+              if (profiling) {
+                profileEnter(first->cl.functionCode, profileBase, 1);
+              }
+              frame = bindArguments(first, newArgs);
+              tree = first->cl.functionCode;
+            } else {
+              result = apply(first, newArgs);
+            }
+            gcUnprotect(1);
+            break;
+          }
         }
-        first = eval(first, frame);
-        result = apply(first, newArgs);
+        break;
       }
+      default:
+          evaluationError("eval: default error");
+    }
+  }
+
+  profileDepth = profileBase;
+  gcUnprotect(2);
+  return result;
+}
 
-      return result;
+// Defined after the table, since it reports on the primitives in it.
+Value *interpreterStatsHelp(Value *args);
+
+struct {
+  char *name;
+  Value *(*function)(Value *);
+} primitives[] = {
+  {"car", carHelp}, {"cdr", cdrHelp}, {"cons", consHelp},
+  {"null?", nullHelp}, {"modulo", moduloHelp}, {"*", multiplyHelp},
+  {"/", divideHelp}, {"+", sumHelp}, {"-", subtractHelp},
+  {"<", lessHelp}, {">", greaterHelp}, {"=", equalHelp},
+  {"make-vector", makeVectorHelp}, {"vector", vectorHelp},
+  {"vector-ref", vectorRefHelp}, {"vector-set!", vectorSetHelp},
+  {"vector-length", vectorLengthHelp}, {"vector-fill!", vectorFillHelp},
+  {"list->vector", listToVectorHelp}, {"vector->list", vectorToListHelp},
+  {"make-f64vector", makeF64VectorHelp}, {"f64vector", f64VectorHelp},
+  {"f64vector-ref", f64VectorRefHelp}, {"f64vector-set!", f64VectorSetHelp},
+  {"f64vector-length", f64VectorLengthHelp},
+  {"f64vector-add", f64AddHelp}, {"f64vector-mul", f64MultiplyHelp},
+  {"f64vector-scale", f64ScaleHelp}, {"f64vector-dot", f64DotHelp},
+  {"f64vector-sum", f64SumHelp}, {"f64vector-min", f64MinHelp},
+  {"f64vector-max", f64MaxHelp},
+  {"make-s64vector", makeS64VectorHelp}, {"s64vector", s64VectorHelp},
+  {"s64vector-ref", s64VectorRefHelp}, {"s64vector-set!", s64VectorSetHelp},
+  {"s64vector-length", s64VectorLengthHelp}, {"s64vector-sum", s64SumHelp},
+  {"s64vector-min", s64MinHelp}, {"s64vector-max", s64MaxHelp},
+  {"s64vector-add", s64AddHelp}, {"s64vector-mul", s64MultiplyHelp},
+  {"s64vector-scale", s64ScaleHelp}, {"s64vector-dot", s64DotHelp},
+  {"make-hash-table", makeHashTableHelp}, {"hash-table-set!", hashTableSetHelp},
+  {"hash-table-ref", hashTableRefHelp},
+  {"hash-table-contains?", hashTableContainsHelp},
+  {"hash-table-delete!", hashTableDeleteHelp},
+  {"hash-table-count", hashTableCountHelp},
+  {"hash-table-keys", hashTableKeysHelp},
+  {"hash-table-values", hashTableValuesHelp},
+  {"hash-table->alist", hashTableToListHelp},
+  {"interpreter-stats", interpreterStatsHelp},
+};
+
+#define PRIMITIVE_COUNT (sizeof(primitives) / sizeof(primitives[0]))
+
+// Returns the statistics as an association list from names to counts. The
+// special forms and primitives each get a nested list, which leaves out the
+// primitives that have not been called.
+Value *statsList() {
+  Value *forms = NULL_VALUE;
+  for (int syntax = ELSE_SYNTAX - 1; syntax > NO_SYNTAX; syntax--) {
+    forms = cons(cons(intern(syntaxName(syntax)), makeInt(stats.forms[syntax])), forms);
+  }
+  Value *called = NULL_VALUE;
+  long primitiveCalls = 0;
+  for (int i = PRIMITIVE_COUNT - 1; i >= 0; i--) {
+    if (stats.primitiveCalls[i] != 0) {
+      called = cons(cons(intern(primitives[i].name), makeInt(stats.primitiveCalls[i])), called);
+      primitiveCalls += stats.primitiveCalls[i];
     }
-    default:
-        evaluationError("eval: default error");
   }
-  
-  return NULL;
+
+  struct {
+    char *name;
+    Value *value;
+  } entries[] = {
+    {"eval-steps", makeInt(stats.evalSteps)},
+    {"calls", makeInt(stats.forms[NO_SYNTAX])},
+    {"special-forms", forms},
+    {"closure-applications", makeInt(stats.closureApplications)},
+    {"primitive-calls", makeInt(primitiveCalls)},
+    {"primitives", called},
+    {"gc-objects", makeInt(gcObjectsAllocated)},
+    {"gc-bytes", makeInt(gcBytesAllocated)},
+    {"talloc-calls", makeInt(stats.tallocCalls)},
+    {"talloc-bytes", makeInt(stats.tallocBytes)},
+    {"frames-created", makeInt(stats.framesCreated)},
+    {"global-lookups", makeInt(stats.globalLookups)},
+    {"local-lookups", makeInt(stats.localLookups)},
+    {"frames-walked", makeInt(stats.framesWalked)},
+  };
+  Value *list = NULL_VALUE;
+  for (int i = sizeof(entries) / sizeof(entries[0]) - 1; i >= 0; i--) {
+    list = cons(cons(intern(entries[i].name), entries[i].value), list);
+  }
+  return list;
 }
 
-void interpret(Value *tree) {
-  Frame *first = talloc(sizeof(Frame));
-  first->bindings = makeNull();
-  first->parent = NULL;
-  while (tree->type != NULL_TYPE) {
-    bind("car", carHelp, first);
-    bind("cdr", cdrHelp, first);
-    bind("cons", consHelp, first);
-    bind("null?", nullHelp, first);
-    bind("modulo", moduloHelp, first);
-    bind("*", multiplyHelp, first);
-    bind("/", divideHelp, first);
-    bind("+", sumHelp, first);
-    bind("-", subtractHelp, first);
-    bind("<", lessHelp, first);
-    bind(">", greaterHelp, first);
-    bind("=", equalHelp, first);
-    print(eval(car(tree), first));
-    tree = cdr(tree);
-    printf("\n");
+Value *interpreterStatsHelp(Value *args) {
+  if (args != NULL_VALUE) {
+    evaluationError("interpreterStatsHelp: invalid length");
   }
-}
\ No newline at end of file
+  return statsList();
+}
+
+void printStats() {
+  Value *list = statsList();
+  while (list != NULL_VALUE) {
+    Value *entry = car(list);
+    if (isFixnum(cdr(entry))) {
+      fprintf(stderr, "%-22s %ld\n", car(entry)->s, (long) intOf(cdr(entry)));
+    } else {
+      fprintf(stderr, "%s\n", car(entry)->s);
+      for (Value *inner = cdr(entry); inner != NULL_VALUE; inner = cdr(inner)) {
+        fprintf(stderr, "  %-20s %ld\n", car(car(inner))->s, (long) intOf(cdr(car(inner))));
+      }
+    }
+    list = cdr(list);
+  }
+}
+
+// Sets up an empty global environment and binds the primitives in it.
+void bindPrimitives() {
+  globalFrame = gcFrame(0);
+  globalFrame->parent = NULL;
+  if (globalTable == NULL) {
+    gcAddRootTracer(traceGlobals);
+  }
+  globalTable = NULL;
+  globalCapacity = 0;
+  globalCount = 0;
+
+  stats.primitiveCalls = talloc(sizeof(long) * PRIMITIVE_COUNT);
+  memset(stats.primitiveCalls, 0, sizeof(long) * PRIMITIVE_COUNT);
+  for (size_t i = 0; i < PRIMITIVE_COUNT; i++) {
+    Value *primitive = gcValue();
+    primitive->type = PRIMITIVE_TYPE;
+    primitive->pf = primitives[i].function;
+    primitive->primitive = i;
+    defineGlobal(intern(primitives[i].name), primitive);
+  }
+}
+
+// Reads the next top-level form, first showing a prompt if someone is typing
+// the program in. Returns NULL at the end of the input.
+Value *readForm(int interactive) {
+  if (interactive) {
+    printf("> ");
+    fflush(stdout);
+  }
+  return readDatum();
+}
+
+// Prints the value of a top-level form. At a terminal it is flushed straight
+// away rather than whenever the buffer fills.
+void printResult(Value *result, int interactive) {
+  print(result);
+  printf("\n");
+  if (interactive) {
+    fflush(stdout);
+  }
+}
+
+void interpret() {
+  bindPrimitives();
+  Value *form = NULL_VALUE;
+  gcProtect(globalFrame);
+  gcProtect(form);
+
+  int interactive = isatty(STDIN_FILENO);
+  while ((form = readForm(interactive)) != NULL) {
+    resolve(&form);
+    // Promote the form out of the nursery before running it. Code is never
+    // young after this, so the evaluator can keep plain pointers into it.
+    gcCollectMinor();
+    printResult(eval(form, globalFrame), interactive);
+  }
+  gcUnprotect(2);
+}
+
+// Like interpret, but compiles each form to bytecode and runs it on the VM
+// instead of walking the tree.
+void interpretCompiled() {
+  bindPrimitives();
+  Value *form = NULL_VALUE;
+  gcProtect(globalFrame);
+  gcProtect(form);
+
+  int interactive = isatty(STDIN_FILENO);
+  while ((form = readForm(interactive)) != NULL) {
+    resolve(&form);
+    form = compile(form);
+    // The VM keeps pointers into its code, so the code must not move.
+    gcCollectMinor();
+    printResult(execute(form, globalFrame), interactive);
+  }
+  gcUnprotect(2);
+}
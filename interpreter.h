@@ -1,8 +1,28 @@
 #ifndef _INTERPRETER
 #define _INTERPRETER
 
-void interpret(Value *tree);
+// Read, evaluate and print each top-level form on stdin in turn, with eval or
+// with the bytecode VM. Each form runs as soon as it has been read, and is
+// garbage once it has run.
+void interpret();
+void interpretCompiled();
 Value *eval(Value *expr, Frame *frame);
 
+// Shared with the VM, which uses the same global frame and primitives.
+extern Frame *globalFrame;
+void bindPrimitives();
+void defineGlobal(Value *symbol, Value *value);
+Value *lookUpSymbol(Value *symbol);
+int setBinding(Value *variable, Value *newVal, Frame *frame);
+void evaluationError(char *error);
+
+// Exposed for microbench.c, which times them on their own.
+Value *lookUpLocal(Value *ref, Frame *frame);
+Value *apply(Value *function, Value *args);
+void print(Value *tree);
+
+// Prints the counts kept in stats.h to stderr.
+void printStats();
+
 #endif
 
@@ -5,6 +5,7 @@
 #include <assert.h>
 #include <string.h>
 #include "talloc.h"
+#include "gc.h"
 
 typedef struct Value Value;
 
@@ -20,16 +21,15 @@ Value *cdr(Value *list) {
   return list->c.cdr;
 }
 
-// Create a new NULL_TYPE value node.
+// Returns the empty list. It is a single immediate constant, so this never
+// allocates, and any '() can be recognized by comparing against NULL_VALUE.
 Value *makeNull() {
-  Value *null = talloc(sizeof(Value));
-  null->type = NULL_TYPE;
-  return null;
+  return NULL_VALUE;
 }
 
 // Create a new CONS_TYPE value node.
 Value *cons(Value *newCar, Value *newCdr) {
-  Value *newCons = talloc(sizeof(Value));
+  Value *newCons = gcValue();
   newCons->type = CONS_TYPE;
   newCons->c.car = newCar;
   newCons->c.cdr = newCdr;
@@ -39,16 +39,16 @@ Value *cons(Value *newCar, Value *newCdr) {
 // Display the contents of the linked list to the screen in some kind of
 // readable format
 void display(Value *list) {
-  if (list->type != NULL_TYPE) {
-    switch (list->type) {
+  if (list != NULL_VALUE) {
+    switch (typeOf(list)) {
     case INT_TYPE:
-        printf("Int: %i\n", list->i);
+        printf("Int: %lld\n", (long long) intOf(list));
         break;
     case DOUBLE_TYPE:
         printf("Double: %lf\n", list->d);
         break;
     case STR_TYPE:
-        printf("String: %s\n", list->s);
+        printf("String: %.*s\n", list->length, list->s);
         break;
     case NULL_TYPE:
         printf("Null type\n");
@@ -94,6 +94,30 @@ void display(Value *list) {
     case PRIMITIVE_TYPE:
       printf("Primitive type\n");
       break;
+    case LOCAL_TYPE:
+      printf("Local type\n");
+      break;
+    case CODE_TYPE:
+      printf("Code type\n");
+      break;
+    case BIGNUM_TYPE:
+      printf("Bignum type\n");
+      break;
+    case VECTOR_TYPE:
+      printf("Vector type\n");
+      break;
+    case OPENVECTOR_TYPE:
+      printf("Open Vector type\n");
+      break;
+    case F64VECTOR_TYPE:
+      printf("F64 Vector type\n");
+      break;
+    case S64VECTOR_TYPE:
+      printf("S64 Vector type\n");
+      break;
+    case HASHTABLE_TYPE:
+      printf("Hash table type\n");
+      break;
     }
   }
 }
@@ -104,10 +128,9 @@ void display(Value *list) {
 // list.
 
 Value *reverse(Value *list) {
-  if (list->type == NULL_TYPE) return makeNull();
-  Value *newlist = makeNull();
+  Value *newlist = NULL_VALUE;
 
-  while (list != NULL && !isNull(list)) {
+  while (list != NULL_VALUE) {
     newlist = cons(car(list), newlist);
     list = list->c.cdr;
   }
@@ -117,20 +140,16 @@ Value *reverse(Value *list) {
 // Utility to check if pointing to a NULL_TYPE value. Use assertions to make sure
 // that this is a legitimate operation.
 bool isNull(Value *value) {
-  if (value->type == NULL_TYPE) {
-   return true;
-  }
-  else return false;
+  return value == NULL_VALUE;
 }
 
-// Measure length of list. Use assertions to make sure that this is a legitimate
-// operation.
+// Measure length of list. An improper list is measured up to its last pair, so
+// this never takes the cdr of something that is not one.
 int length(Value *value) {
-  if (value->type == NULL_TYPE) return 0;
   int count = 0;
   Value *curr = value;
 
-  while (curr != NULL && !isNull(curr)) {
+  while (typeOf(curr) == CONS_TYPE) {
     curr = cdr(curr);
     count++;
   }
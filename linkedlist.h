@@ -4,7 +4,7 @@
 #ifndef _LINKEDLIST
 #define _LINKEDLIST
 
-// Create a new NULL_TYPE value node.
+// Returns the empty list, the shared NULL_VALUE constant.
 Value *makeNull();
 
 // Create a new CONS_TYPE value node.
@@ -1,16 +1,100 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "tokenizer.h"
 #include "value.h"
 #include "linkedlist.h"
 #include "parser.h"
 #include "talloc.h"
+#include "gc.h"
 #include "interpreter.h"
+#include "profile.h"
 
-int main() {
+// Parses a byte count with an optional k, m or g suffix.
+size_t parseSize(char *text) {
+    char *end;
+    size_t size = strtoul(text, &end, 10);
+    if (*end == 'k' || *end == 'K') {
+        size *= 1024;
+    } else if (*end == 'm' || *end == 'M') {
+        size *= 1024 * 1024;
+    } else if (*end == 'g' || *end == 'G') {
+        size *= 1024 * 1024 * 1024;
+    }
+    return size;
+}
+
+// Prints the process's peak resident set size to stderr. This comes from
+// /proc rather than getrusage, because Linux carries ru_maxrss over exec and
+// so would report the parent's peak for a process started by a big one.
+void printPeakMemory() {
+    FILE *status = fopen("/proc/self/status", "r");
+    if (status == NULL) {
+        return;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), status) != NULL) {
+        if (!strncmp(line, "VmHWM:", 6)) {
+            fprintf(stderr, "memory: %ld kB peak resident\n", strtol(line + 6, NULL, 10));
+        }
+    }
+    fclose(status);
+}
+
+int main(int argc, char **argv) {
+    int compiled = 0;
+    int gcStats = 0;
+    int printingStats = 0;
+    char *profileFile = NULL;
+    int profile = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strncmp(argv[i], "--heap-limit=", 13)) {
+            gcSetHeapLimit(parseSize(argv[i] + 13));
+        } else if (!strcmp(argv[i], "--vm")) {
+            compiled = 1;
+        } else if (!strcmp(argv[i], "--gc-stats")) {
+            gcStats = 1;
+        } else if (!strcmp(argv[i], "--stats")) {
+            printingStats = 1;
+        } else if (!strcmp(argv[i], "--profile")) {
+            profile = 1;
+        } else if (!strncmp(argv[i], "--profile=", 10)) {
+            profile = 1;
+            profileFile = argv[i] + 10;
+        } else {
+            printf("Usage: %s [--heap-limit=BYTES[k|m|g]] [--vm] [--gc-stats] [--stats] [--profile[=FILE]] < program.scm\n", argv[0]);
+            return 1;
+        }
+    }
 
-    Value *list = tokenize();
-    Value *tree = parse(list);
-    interpret(tree);
+    if (profile) {
+        profileStart();
+    }
+    if (compiled) {
+        interpretCompiled();
+    } else {
+        interpret();
+    }
+    if (profile) {
+        // Folded stacks go to stderr unless a file is given, so they stay
+        // out of the program's own output.
+        FILE *out = profileFile != NULL ? fopen(profileFile, "w") : stderr;
+        if (out == NULL) {
+            perror(profileFile);
+            return 1;
+        }
+        profileFinish(out);
+        if (out != stderr) {
+            fclose(out);
+        }
+    }
+    if (printingStats) {
+        printStats();
+    }
+    if (gcStats) {
+        gcPrintStats();
+        printPeakMemory();
+    }
 
     tfree();
     return 0;
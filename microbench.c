@@ -0,0 +1,212 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "value.h"
+#include "linkedlist.h"
+#include "talloc.h"
+#include "gc.h"
+#include "symbol.h"
+#include "resolver.h"
+#include "interpreter.h"
+
+// Times the interpreter's hot internal routines one at a time, reporting
+// nanoseconds and collected heap objects per operation. Build it with
+// make microbench, adding optimization flags through CFLAGS to match the
+// interpreter being measured.
+
+#define LIST_LENGTH 1000
+#define MAX_DEPTH 16
+
+// Everything the benchmarks work on. They are all roots.
+Value *list;
+Value *ref;
+Frame *frames[MAX_DEPTH + 1];
+Value *primitive;
+Value *primitiveArgs;
+Value *closureCall;
+Value *primitiveCall;
+
+double now() {
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec * 1e9 + time.tv_nsec;
+}
+
+// Warms body up with a hundredth of the iterations, then times it and prints
+// the cost of each operation. body returns how many operations it did.
+void measure(char *name, long (*body)(long iterations), long iterations) {
+  body(iterations / 100);
+  size_t objects = gcObjectsAllocated;
+  double start = now();
+  long done = body(iterations);
+  double elapsed = now() - start;
+  printf("%-28s %10.1f ns/op %10.2f objects/op\n", name, elapsed / done,
+         (double) (gcObjectsAllocated - objects) / done);
+}
+
+long benchTalloc(long iterations) {
+  for (long i = 0; i < iterations; i++) {
+    talloc(sizeof(Value));
+  }
+  return iterations;
+}
+
+long benchGcValue(long iterations) {
+  for (long i = 0; i < iterations; i++) {
+    gcValue();
+    if (i % 1024 == 0) {
+      gcSafePoint();
+    }
+  }
+  return iterations;
+}
+
+long benchCons(long iterations) {
+  Value *built = NULL_VALUE;
+  gcProtect(built);
+  for (long i = 0; i < iterations; i++) {
+    built = i % LIST_LENGTH == 0 ? NULL_VALUE : cons(makeInt(i), built);
+    if (i % 1024 == 0) {
+      gcSafePoint();
+    }
+  }
+  gcUnprotect(1);
+  return iterations;
+}
+
+// reverse and length are timed per element, over a list of LIST_LENGTH.
+long benchReverse(long iterations) {
+  long rounds = iterations / LIST_LENGTH;
+  for (long i = 0; i < rounds; i++) {
+    reverse(list);
+    gcSafePoint();
+  }
+  return rounds * LIST_LENGTH;
+}
+
+long benchLength(long iterations) {
+  long rounds = iterations / LIST_LENGTH;
+  long total = 0;
+  for (long i = 0; i < rounds; i++) {
+    total += length(list);
+  }
+  return total;
+}
+
+long benchLookUpSymbol(long iterations) {
+  Value *symbol = intern("vector-ref");
+  for (long i = 0; i < iterations; i++) {
+    lookUpSymbol(symbol);
+  }
+  return iterations;
+}
+
+int depth;
+
+long benchLookUpLocal(long iterations) {
+  ref->ref.depth = depth;
+  for (long i = 0; i < iterations; i++) {
+    lookUpLocal(ref, frames[depth]);
+  }
+  return iterations;
+}
+
+long benchApplyPrimitive(long iterations) {
+  for (long i = 0; i < iterations; i++) {
+    apply(primitive, primitiveArgs);
+    if (i % 1024 == 0) {
+      gcSafePoint();
+    }
+  }
+  return iterations;
+}
+
+long benchEvalPrimitiveCall(long iterations) {
+  for (long i = 0; i < iterations; i++) {
+    eval(primitiveCall, globalFrame);
+  }
+  return iterations;
+}
+
+long benchEvalClosureCall(long iterations) {
+  for (long i = 0; i < iterations; i++) {
+    eval(closureCall, globalFrame);
+  }
+  return iterations;
+}
+
+// Builds a call of the function named name on two small integers, resolved
+// and promoted out of the nursery the way interpret prepares a form.
+Value *callForm(char *name) {
+  Value *form = cons(intern(name), cons(makeInt(1), cons(makeInt(2), NULL_VALUE)));
+  resolve(&form);
+  return form;
+}
+
+int main() {
+  bindPrimitives();
+  gcProtect(globalFrame);
+  gcProtect(list);
+  gcProtect(ref);
+  for (int i = 0; i <= MAX_DEPTH; i++) {
+    gcProtect(frames[i]);
+  }
+  gcProtect(primitive);
+  gcProtect(primitiveArgs);
+  gcProtect(closureCall);
+  gcProtect(primitiveCall);
+
+  list = NULL_VALUE;
+  for (int i = 0; i < LIST_LENGTH; i++) {
+    list = cons(makeInt(i), list);
+  }
+
+  // frames[d] is d frames below the one holding the variable.
+  frames[0] = gcFrame(1);
+  frames[0]->parent = globalFrame;
+  frames[0]->slots[0] = makeInt(0);
+  for (int i = 1; i <= MAX_DEPTH; i++) {
+    frames[i] = gcFrame(1);
+    frames[i]->parent = frames[i - 1];
+    frames[i]->slots[0] = makeInt(i);
+  }
+  ref = gcValue();
+  ref->type = LOCAL_TYPE;
+  ref->ref.slot = 0;
+  ref->ref.name = intern("x");
+
+  primitive = lookUpSymbol(intern("+"));
+  primitiveArgs = cons(makeInt(2), cons(makeInt(1), NULL_VALUE));
+
+  // (define first (lambda (a b) a))
+  Value *define = cons(intern("define"), cons(intern("first"),
+      cons(cons(intern("lambda"), cons(cons(intern("a"), cons(intern("b"), NULL_VALUE)),
+           cons(intern("a"), NULL_VALUE))), NULL_VALUE)));
+  resolve(&define);
+  eval(define, globalFrame);
+  closureCall = callForm("first");
+  primitiveCall = callForm("+");
+  gcCollectMinor();
+
+  measure("talloc", benchTalloc, 1000000);
+  measure("gcValue", benchGcValue, 10000000);
+  measure("cons", benchCons, 10000000);
+  measure("reverse (per element)", benchReverse, 10000000);
+  measure("length (per element)", benchLength, 100000000);
+  measure("lookUpSymbol (global)", benchLookUpSymbol, 10000000);
+  int depths[] = {0, 1, 2, 4, 8, 16};
+  for (int i = 0; i < sizeof(depths) / sizeof(depths[0]); i++) {
+    char name[32];
+    depth = depths[i];
+    snprintf(name, sizeof(name), "lookUpLocal (depth %d)", depth);
+    measure(name, benchLookUpLocal, 10000000);
+  }
+  measure("apply (primitive +)", benchApplyPrimitive, 10000000);
+  measure("eval (+ 1 2)", benchEvalPrimitiveCall, 1000000);
+  measure("eval (first 1 2)", benchEvalClosureCall, 1000000);
+
+  gcUnprotect(8 + MAX_DEPTH + 1);
+  tfree();
+  return 0;
+}
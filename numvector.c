@@ -0,0 +1,305 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "numvector.h"
+#include "value.h"
+#include "gc.h"
+
+// The double kernels are written once against this handful of operations on
+// a register of LANES doubles. Without a vector unit LANES is left undefined
+// and only the scalar loops that finish off each kernel are compiled.
+#if defined(__AVX__)
+#include <immintrin.h>
+#define LANES 4
+typedef __m256d lanes;
+#define loadLanes _mm256_loadu_pd
+#define storeLanes _mm256_storeu_pd
+#define addLanes _mm256_add_pd
+#define multiplyLanes _mm256_mul_pd
+#define minLanes _mm256_min_pd
+#define maxLanes _mm256_max_pd
+#define splatLanes _mm256_set1_pd
+#define nanLanes(x) _mm256_cmp_pd(x, x, _CMP_UNORD_Q)
+#define orLanes _mm256_or_pd
+#define anyLanes _mm256_movemask_pd
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define LANES 2
+typedef __m128d lanes;
+#define loadLanes _mm_loadu_pd
+#define storeLanes _mm_storeu_pd
+#define addLanes _mm_add_pd
+#define multiplyLanes _mm_mul_pd
+#define minLanes _mm_min_pd
+#define maxLanes _mm_max_pd
+#define splatLanes _mm_set1_pd
+#define nanLanes(x) _mm_cmpunord_pd(x, x)
+#define orLanes _mm_or_pd
+#define anyLanes _mm_movemask_pd
+#endif
+
+Value *makeF64Vector(int length) {
+  Value *vector = gcAlloc(sizeof(Value) + sizeof(double) * length, GC_VALUE);
+  vector->type = F64VECTOR_TYPE;
+  vector->vector.length = length;
+  memset(doublesOf(vector), 0, sizeof(double) * length);
+  return vector;
+}
+
+Value *makeS64Vector(int length) {
+  Value *vector = gcAlloc(sizeof(Value) + sizeof(int64_t) * length, GC_VALUE);
+  vector->type = S64VECTOR_TYPE;
+  vector->vector.length = length;
+  memset(int64sOf(vector), 0, sizeof(int64_t) * length);
+  return vector;
+}
+
+void f64Add(double *out, const double *a, const double *b, int length) {
+  int i = 0;
+#ifdef LANES
+  for (; i + LANES <= length; i += LANES) {
+    storeLanes(out + i, addLanes(loadLanes(a + i), loadLanes(b + i)));
+  }
+#endif
+  for (; i < length; i++) {
+    out[i] = a[i] + b[i];
+  }
+}
+
+void f64Multiply(double *out, const double *a, const double *b, int length) {
+  int i = 0;
+#ifdef LANES
+  for (; i + LANES <= length; i += LANES) {
+    storeLanes(out + i, multiplyLanes(loadLanes(a + i), loadLanes(b + i)));
+  }
+#endif
+  for (; i < length; i++) {
+    out[i] = a[i] * b[i];
+  }
+}
+
+void f64Scale(double *out, const double *a, double factor, int length) {
+  int i = 0;
+#ifdef LANES
+  lanes factors = splatLanes(factor);
+  for (; i + LANES <= length; i += LANES) {
+    storeLanes(out + i, multiplyLanes(loadLanes(a + i), factors));
+  }
+#endif
+  for (; i < length; i++) {
+    out[i] = a[i] * factor;
+  }
+}
+
+#ifdef LANES
+double sumLanes(lanes sums) {
+  double parts[LANES];
+  storeLanes(parts, sums);
+  double sum = 0;
+  for (int i = 0; i < LANES; i++) {
+    sum += parts[i];
+  }
+  return sum;
+}
+#endif
+
+// The reductions keep two registers of partial sums going, so that each
+// addition does not have to wait for the one before it.
+double f64Dot(const double *a, const double *b, int length) {
+  double sum = 0;
+  int i = 0;
+#ifdef LANES
+  lanes even = splatLanes(0);
+  lanes odd = splatLanes(0);
+  for (; i + 2 * LANES <= length; i += 2 * LANES) {
+    even = addLanes(even, multiplyLanes(loadLanes(a + i), loadLanes(b + i)));
+    odd = addLanes(odd, multiplyLanes(loadLanes(a + i + LANES),
+                                      loadLanes(b + i + LANES)));
+  }
+  sum = sumLanes(addLanes(even, odd));
+#endif
+  for (; i < length; i++) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+double f64Sum(const double *a, int length) {
+  double sum = 0;
+  int i = 0;
+#ifdef LANES
+  lanes even = splatLanes(0);
+  lanes odd = splatLanes(0);
+  for (; i + 2 * LANES <= length; i += 2 * LANES) {
+    even = addLanes(even, loadLanes(a + i));
+    odd = addLanes(odd, loadLanes(a + i + LANES));
+  }
+  sum = sumLanes(addLanes(even, odd));
+#endif
+  for (; i < length; i++) {
+    sum += a[i];
+  }
+  return sum;
+}
+
+// min and max instructions give their second operand when either is NaN,
+// which would make the answer depend on where a NaN falls among the lanes.
+// Instead any NaN makes the result NaN, whichever path it is seen on.
+double f64Min(const double *a, int length) {
+  double smallest = a[0];
+  int nan = 0;
+  int i = 0;
+#ifdef LANES
+  if (length >= LANES) {
+    lanes smallests = loadLanes(a);
+    lanes nans = nanLanes(smallests);
+    for (i = LANES; i + LANES <= length; i += LANES) {
+      lanes next = loadLanes(a + i);
+      smallests = minLanes(smallests, next);
+      nans = orLanes(nans, nanLanes(next));
+    }
+    nan = anyLanes(nans);
+    double parts[LANES];
+    storeLanes(parts, smallests);
+    for (int j = 0; j < LANES; j++) {
+      smallest = parts[j] < smallest ? parts[j] : smallest;
+    }
+  }
+#endif
+  for (; i < length; i++) {
+    nan |= isnan(a[i]);
+    smallest = a[i] < smallest ? a[i] : smallest;
+  }
+  return nan ? NAN : smallest;
+}
+
+double f64Max(const double *a, int length) {
+  double largest = a[0];
+  int nan = 0;
+  int i = 0;
+#ifdef LANES
+  if (length >= LANES) {
+    lanes largests = loadLanes(a);
+    lanes nans = nanLanes(largests);
+    for (i = LANES; i + LANES <= length; i += LANES) {
+      lanes next = loadLanes(a + i);
+      largests = maxLanes(largests, next);
+      nans = orLanes(nans, nanLanes(next));
+    }
+    nan = anyLanes(nans);
+    double parts[LANES];
+    storeLanes(parts, largests);
+    for (int j = 0; j < LANES; j++) {
+      largest = parts[j] > largest ? parts[j] : largest;
+    }
+  }
+#endif
+  for (; i < length; i++) {
+    nan |= isnan(a[i]);
+    largest = a[i] > largest ? a[i] : largest;
+  }
+  return nan ? NAN : largest;
+}
+
+// 64-bit integer comparisons only come with AVX2; SSE2 has none, so without
+// it these are plain loops.
+int64_t s64Min(const int64_t *a, int length) {
+  int64_t smallest = a[0];
+  int i = 0;
+#if defined(__AVX2__)
+  if (length >= 4) {
+    __m256i smallests = _mm256_loadu_si256((const __m256i *) a);
+    for (i = 4; i + 4 <= length; i += 4) {
+      __m256i next = _mm256_loadu_si256((const __m256i *) (a + i));
+      smallests = _mm256_blendv_epi8(smallests, next,
+                                     _mm256_cmpgt_epi64(smallests, next));
+    }
+    int64_t parts[4];
+    _mm256_storeu_si256((__m256i *) parts, smallests);
+    for (int j = 0; j < 4; j++) {
+      smallest = parts[j] < smallest ? parts[j] : smallest;
+    }
+  }
+#endif
+  for (; i < length; i++) {
+    smallest = a[i] < smallest ? a[i] : smallest;
+  }
+  return smallest;
+}
+
+int64_t s64Max(const int64_t *a, int length) {
+  int64_t largest = a[0];
+  int i = 0;
+#if defined(__AVX2__)
+  if (length >= 4) {
+    __m256i largests = _mm256_loadu_si256((const __m256i *) a);
+    for (i = 4; i + 4 <= length; i += 4) {
+      __m256i next = _mm256_loadu_si256((const __m256i *) (a + i));
+      largests = _mm256_blendv_epi8(largests, next,
+                                    _mm256_cmpgt_epi64(next, largests));
+    }
+    int64_t parts[4];
+    _mm256_storeu_si256((__m256i *) parts, largests);
+    for (int j = 0; j < 4; j++) {
+      largest = parts[j] > largest ? parts[j] : largest;
+    }
+  }
+#endif
+  for (; i < length; i++) {
+    largest = a[i] > largest ? a[i] : largest;
+  }
+  return largest;
+}
+
+// Addition overflowed exactly when the result's sign differs from the signs
+// of both operands, so the vector loop collects that across lanes and the
+// result is checked once at the end.
+int s64Add(int64_t *out, const int64_t *a, const int64_t *b, int length) {
+  int overflow = 0;
+  int i = 0;
+#if defined(__AVX2__)
+  __m256i signs = _mm256_setzero_si256();
+  for (; i + 4 <= length; i += 4) {
+    __m256i x = _mm256_loadu_si256((const __m256i *) (a + i));
+    __m256i y = _mm256_loadu_si256((const __m256i *) (b + i));
+    __m256i sum = _mm256_add_epi64(x, y);
+    signs = _mm256_or_si256(signs, _mm256_and_si256(_mm256_xor_si256(x, sum),
+                                                    _mm256_xor_si256(y, sum)));
+    _mm256_storeu_si256((__m256i *) (out + i), sum);
+  }
+  overflow = _mm256_movemask_pd(_mm256_castsi256_pd(signs)) != 0;
+#elif defined(__SSE2__)
+  __m128i signs = _mm_setzero_si128();
+  for (; i + 2 <= length; i += 2) {
+    __m128i x = _mm_loadu_si128((const __m128i *) (a + i));
+    __m128i y = _mm_loadu_si128((const __m128i *) (b + i));
+    __m128i sum = _mm_add_epi64(x, y);
+    signs = _mm_or_si128(signs, _mm_and_si128(_mm_xor_si128(x, sum),
+                                              _mm_xor_si128(y, sum)));
+    _mm_storeu_si128((__m128i *) (out + i), sum);
+  }
+  overflow = _mm_movemask_pd(_mm_castsi128_pd(signs)) != 0;
+#endif
+  for (; i < length; i++) {
+    overflow |= __builtin_add_overflow(a[i], b[i], &out[i]);
+  }
+  return overflow;
+}
+
+// There is no 64-bit lane multiply before AVX-512, so multiplying is left to
+// the compiler's scalar code.
+int s64Multiply(int64_t *out, const int64_t *a, const int64_t *b, int length) {
+  int overflow = 0;
+  for (int i = 0; i < length; i++) {
+    overflow |= __builtin_mul_overflow(a[i], b[i], &out[i]);
+  }
+  return overflow;
+}
+
+int s64Scale(int64_t *out, const int64_t *a, int64_t factor, int length) {
+  int overflow = 0;
+  for (int i = 0; i < length; i++) {
+    overflow |= __builtin_mul_overflow(a[i], factor, &out[i]);
+  }
+  return overflow;
+}
@@ -0,0 +1,34 @@
+#include <stdint.h>
+#include "value.h"
+
+#ifndef _NUMVECTOR
+#define _NUMVECTOR
+
+// Allocates an f64vector or an s64vector of length elements, all zero.
+Value *makeF64Vector(int length);
+Value *makeS64Vector(int length);
+
+// Bulk kernels over raw arrays of doubles. out may be the same array as an
+// input. They use the widest vector instructions the build targets (AVX when
+// compiled with -mavx or -mavx2, SSE2 otherwise on x86-64) and plain loops
+// everywhere else.
+void f64Add(double *out, const double *a, const double *b, int length);
+void f64Multiply(double *out, const double *a, const double *b, int length);
+void f64Scale(double *out, const double *a, double factor, int length);
+double f64Dot(const double *a, const double *b, int length);
+double f64Sum(const double *a, int length);
+
+// The smallest and largest elements. length must not be zero. The f64 ones
+// give NaN if any element is NaN.
+double f64Min(const double *a, int length);
+double f64Max(const double *a, int length);
+int64_t s64Min(const int64_t *a, int length);
+int64_t s64Max(const int64_t *a, int length);
+
+// Elementwise kernels over raw arrays of int64_ts, as for doubles above. They
+// return nonzero if any element overflowed, leaving that element wrapped.
+int s64Add(int64_t *out, const int64_t *a, const int64_t *b, int length);
+int s64Multiply(int64_t *out, const int64_t *a, const int64_t *b, int length);
+int s64Scale(int64_t *out, const int64_t *a, int64_t factor, int length);
+
+#endif
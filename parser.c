@@ -5,27 +5,105 @@
 #include "linkedlist.h"
 #include "tokenizer.h"
 #include "talloc.h"
+#include "symbol.h"
+#include "bignum.h"
+#include "vector.h"
+#include "profile.h"
 
-Value *treeHelp(int *depth, Value *token, Value *tree) {
-  if (token->type != CLOSE_TYPE) {
-    if (token->type == OPEN_TYPE) {
-      *depth = *depth + 1;
+// Where tokens come from: the list parse was handed, or stdin through
+// nextToken when it is NULL.
+Value *pendingTokens = NULL;
+
+Value *pullToken() {
+  if (pendingTokens == NULL) {
+    return nextToken();
+  }
+  if (pendingTokens == NULL_VALUE) {
+    return NULL;
+  }
+  Value *token = car(pendingTokens);
+  pendingTokens = cdr(pendingTokens);
+  return token;
+}
+
+void parenthesesError() {
+  printf("Syntax error: Parentheses\n");
+  texit(1);
+}
+
+Value *readList(valueType close);
+
+// Reads the datum that starts with token, pulling the rest of its tokens.
+Value *readFrom(Value *token) {
+  if (token == NULL) {
+    parenthesesError();
+  }
+  switch (typeOf(token)) {
+    case OPEN_TYPE: {
+      int line = tokenLine;
+      Value *list = readList(CLOSE_TYPE);
+      if (profiling && list != NULL_VALUE && typeOf(car(list)) == SYMBOL_TYPE &&
+          car(list)->syntax == LAMBDA_SYNTAX) {
+        profileNoteSource(cdr(list), line);
+      }
+      return list;
     }
-    tree = cons(token, tree);
-  } else {
-    if (*depth < 1) {
-      printf("Syntax error: Parentheses\n");
-      texit(1);
+    case OPENBRACKET_TYPE:
+      return readList(CLOSEBRACKET_TYPE);
+    case OPENVECTOR_TYPE: {
+      Value *vector = listToVector(readList(CLOSE_TYPE));
+      if (vector == NULL) {
+        printf("Syntax error: dot in vector\n");
+        texit(1);
+      }
+      return vector;
     }
-    Value *temp = makeNull();
-    *depth = *depth - 1;
-    while (car(tree)->type != OPEN_TYPE) {
-      temp = cons(car(tree), temp);
-      tree = cdr(tree);
+    case SINGLEQUOTE_TYPE: {
+      // 'datum is read as (quote datum).
+      Value *quoted = readFrom(pullToken());
+      return cons(intern("quote"), cons(quoted, NULL_VALUE));
     }
-    tree->c.car = temp;
+    case CLOSE_TYPE:
+    case CLOSEBRACKET_TYPE:
+    case DOT_TYPE:
+      parenthesesError();
+      return NULL;
+    default:
+      return token;
+  }
+}
+
+// Reads the elements of a list up to its closing token, consing each one onto
+// the end so the list never needs reversing.
+Value *readList(valueType close) {
+  Value *list = NULL_VALUE;
+  Value **tail = &list;
+  while (1) {
+    Value *token = pullToken();
+    if (token == NULL) {
+      parenthesesError();
+    }
+    if (typeOf(token) == CLOSE_TYPE || typeOf(token) == CLOSEBRACKET_TYPE) {
+      if (typeOf(token) != close) {
+        parenthesesError();
+      }
+      return list;
+    }
+    if (typeOf(token) == DOT_TYPE) {
+      // A dot needs something before it and exactly one datum after it.
+      if (list == NULL_VALUE) {
+        parenthesesError();
+      }
+      *tail = readFrom(pullToken());
+      token = pullToken();
+      if (token == NULL || typeOf(token) != close) {
+        parenthesesError();
+      }
+      return list;
+    }
+    *tail = cons(readFrom(token), NULL_VALUE);
+    tail = &(*tail)->c.cdr;
   }
-  return tree;
 }
 
 // Takes a list of tokens from a Scheme program, and returns a pointer to a
@@ -35,49 +113,67 @@ Value *parse(Value *tokens) {
     printf("Null list");
     texit(1);
   }
-  Value *tree = makeNull();
-  Value *list = tokens;
-  int depth = 0;
-
-  while (list->type != NULL_TYPE) {
-    tree = treeHelp(&depth, car(list), tree);
-    list = cdr(list);
+  pendingTokens = tokens;
+  Value *tree = NULL_VALUE;
+  Value **tail = &tree;
+  Value *token;
+  while ((token = pullToken()) != NULL) {
+    *tail = cons(readFrom(token), NULL_VALUE);
+    tail = &(*tail)->c.cdr;
   }
+  pendingTokens = NULL;
+  return tree;
+}
 
-  if (depth != 0) {
-    printf("Syntax error: Parentheses\n");
-    texit(1);
+// Reads the next top-level datum from stdin, pulling tokens only until it is
+// complete, and returns its parse tree. Returns NULL at the end of the input.
+Value *readDatum() {
+  Value *token = nextToken();
+  if (token == NULL) {
+    return NULL;
   }
-  
-  return reverse(tree);
+  return readFrom(token);
 }
 
+void printTreeHelp(Value *tree);
+
 void printTokenHelp(Value *tree) {
-  if (tree->type == INT_TYPE) {
-    printf("%i", tree->i);
-  } else if (tree->type == DOUBLE_TYPE) {
+  if (typeOf(tree) == INT_TYPE || typeOf(tree) == BIGNUM_TYPE) {
+    printInteger(tree);
+  } else if (typeOf(tree) == DOUBLE_TYPE) {
     printf("%lf", tree->d);
-  } else if (tree->type == STR_TYPE) {
-    printf("%s", tree->s);
-  } else if (tree->type == NULL_TYPE) {
+  } else if (typeOf(tree) == STR_TYPE) {
+    printf("\"%.*s\"", tree->length, tree->s);
+  } else if (typeOf(tree) == BOOL_TYPE) {
+    printf(boolOf(tree) ? "#t" : "#f");
+  } else if (tree == NULL_VALUE) {
     printf("()");
+  } else if (typeOf(tree) == VECTOR_TYPE) {
+    printf("#(");
+    for (int i = 0; i < tree->vector.length; i++) {
+      if (i > 0) {
+        printf(" ");
+      }
+      printTreeHelp(elementsOf(tree)[i]);
+    }
+    printf(")");
   } else {
     printf("%s", tree->s);
   }
 }
 
 void printTreeHelp(Value *tree) {
-  if (tree->type != CONS_TYPE) {
+  if (typeOf(tree) != CONS_TYPE) {
     printTokenHelp(tree);
   } else {
     printf("(");
-    while (tree->type != NULL_TYPE) {
-      if (car(tree)->type != CONS_TYPE) {
+    while (tree != NULL_VALUE) {
+      if (typeOf(car(tree)) != CONS_TYPE) {
         printTokenHelp(car(tree));
       } else {
         printTreeHelp(car(tree));
       }
-      if (cdr(tree)->type != NULL_TYPE) {
+      if (cdr(tree) != NULL_VALUE) {
         printf(")");
       }
       tree = cdr(tree);
@@ -89,7 +185,7 @@ void printTreeHelp(Value *tree) {
 // Prints the tree to the screen in a readable fashion. It should look just like
 // Scheme code; use parentheses to indicate subtrees.
 void printTree(Value *tree) {
-  while (tree->type != NULL_TYPE) {
+  while (tree != NULL_VALUE) {
     printTreeHelp(car(tree));
     tree = cdr(tree);
     printf(" ");
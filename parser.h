@@ -7,6 +7,10 @@
 // parse tree representing that program.
 Value *parse(Value *tokens);
 
+// Reads the next top-level datum from stdin, pulling tokens only until it is
+// complete, and returns its parse tree. Returns NULL at the end of the input.
+Value *readDatum();
+
 
 // Prints the tree to the screen in a readable fashion. It should look just like
 // Scheme code; use parentheses to indicate subtrees.
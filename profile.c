@@ -0,0 +1,247 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/time.h>
+#include "profile.h"
+#include "value.h"
+#include "talloc.h"
+#include "gc.h"
+
+#define SAMPLE_INTERVAL_USEC 1000
+#define SAMPLE_CAPACITY (1 << 22)
+
+int profiling;
+Value *volatile profileStack[PROFILE_STACK_SIZE];
+volatile int profileDepth;
+
+// Each sample is its depth followed by that many procedures, outermost first.
+// The buffer is allocated up front since the signal handler cannot allocate.
+Value **samples;
+volatile size_t sampleTop;
+volatile long samplesDropped;
+
+// The lambda forms the parser has seen, searched linearly. The forms are
+// still young when they are recorded, so they are traced as roots, which
+// keeps the pointers here current as the forms move.
+typedef struct Source {
+  Value *lambdaArgs;
+  int line;
+} Source;
+
+Source *sources;
+int sourceCount;
+int sourceCapacity;
+
+// Open-addressing hash table of known procedures, keyed by functionCode. The
+// keys are old objects, which never move, so their addresses hash.
+typedef struct Procedure {
+  Value *code;
+  char *name;
+  int line;
+} Procedure;
+
+Procedure *procedures;
+size_t procedureCapacity;
+size_t procedureCount;
+
+void traceProfile(void (*visit)(void **)) {
+  for (int i = 0; i < sourceCount; i++) {
+    visit((void **) &sources[i].lambdaArgs);
+  }
+  for (size_t i = 0; i < procedureCapacity; i++) {
+    if (procedures[i].code != NULL) {
+      visit((void **) &procedures[i].code);
+    }
+  }
+}
+
+void profileSample(int signum) {
+  (void) signum;
+  int depth = profileDepth;
+  if (depth > PROFILE_STACK_SIZE) {
+    depth = PROFILE_STACK_SIZE;
+  }
+  size_t top = sampleTop;
+  if (top + depth + 1 > SAMPLE_CAPACITY) {
+    samplesDropped++;
+    return;
+  }
+  samples[top] = (Value *) (intptr_t) depth;
+  for (int i = 0; i < depth; i++) {
+    samples[top + 1 + i] = profileStack[i];
+  }
+  sampleTop = top + depth + 1;
+}
+
+void profileStart() {
+  samples = talloc(sizeof(Value *) * SAMPLE_CAPACITY);
+  gcAddRootTracer(traceProfile);
+  profiling = 1;
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = profileSample;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGPROF, &action, NULL);
+
+  struct itimerval timer;
+  timer.it_interval.tv_sec = 0;
+  timer.it_interval.tv_usec = SAMPLE_INTERVAL_USEC;
+  timer.it_value = timer.it_interval;
+  setitimer(ITIMER_PROF, &timer, NULL);
+}
+
+void profileNoteSource(Value *lambdaArgs, int line) {
+  if (sourceCount == sourceCapacity) {
+    int capacity = sourceCapacity == 0 ? 64 : sourceCapacity * 2;
+    Source *grown = talloc(sizeof(Source) * capacity);
+    if (sourceCount > 0) {
+      memcpy(grown, sources, sizeof(Source) * sourceCount);
+    }
+    sources = grown;
+    sourceCapacity = capacity;
+  }
+  sources[sourceCount].lambdaArgs = lambdaArgs;
+  sources[sourceCount].line = line;
+  sourceCount++;
+}
+
+int profileSourceLine(Value *lambdaArgs) {
+  for (int i = sourceCount - 1; i >= 0; i--) {
+    if (sources[i].lambdaArgs == lambdaArgs) {
+      return sources[i].line;
+    }
+  }
+  return 0;
+}
+
+size_t procedureSlot(Procedure *table, size_t capacity, Value *code) {
+  size_t slot = (((uintptr_t) code >> 3) * 2654435761u) & (capacity - 1);
+  while (table[slot].code != NULL && table[slot].code != code) {
+    slot = (slot + 1) & (capacity - 1);
+  }
+  return slot;
+}
+
+// Returns the entry for code, or NULL if it is not known.
+Procedure *findProcedure(Value *code) {
+  if (procedureCapacity == 0) {
+    return NULL;
+  }
+  Procedure *procedure = &procedures[procedureSlot(procedures, procedureCapacity, code)];
+  return procedure->code == NULL ? NULL : procedure;
+}
+
+void profileNoteCode(Value *code, int line) {
+  if (findProcedure(code) != NULL) {
+    return;
+  }
+  if (2 * (procedureCount + 1) > procedureCapacity) {
+    size_t capacity = procedureCapacity == 0 ? 64 : procedureCapacity * 2;
+    Procedure *table = talloc(sizeof(Procedure) * capacity);
+    memset(table, 0, sizeof(Procedure) * capacity);
+    for (size_t i = 0; i < procedureCapacity; i++) {
+      if (procedures[i].code != NULL) {
+        table[procedureSlot(table, capacity, procedures[i].code)] = procedures[i];
+      }
+    }
+    procedures = table;
+    procedureCapacity = capacity;
+  }
+  Procedure *procedure = &procedures[procedureSlot(procedures, procedureCapacity, code)];
+  procedure->code = code;
+  procedure->name = NULL;
+  procedure->line = line;
+  procedureCount++;
+}
+
+void profileNoteLambda(Value *code, Value *lambdaArgs) {
+  if (findProcedure(code) == NULL) {
+    profileNoteCode(code, profileSourceLine(lambdaArgs));
+  }
+}
+
+void profileNameCode(Value *code, char *name) {
+  Procedure *procedure = findProcedure(code);
+  if (procedure != NULL && procedure->name == NULL) {
+    procedure->name = name;
+  }
+}
+
+// Appends the label of one procedure to a folded stack.
+void appendLabel(char **text, size_t *length, size_t *capacity, Value *code) {
+  Procedure *procedure = findProcedure(code);
+  char label[128];
+  if (procedure == NULL) {
+    snprintf(label, sizeof(label), "?");
+  } else if (procedure->line > 0) {
+    snprintf(label, sizeof(label), "%s:%d",
+             procedure->name != NULL ? procedure->name : "lambda", procedure->line);
+  } else {
+    snprintf(label, sizeof(label), "%s",
+             procedure->name != NULL ? procedure->name : "lambda");
+  }
+  size_t needed = strlen(label) + 1;
+  if (*length + needed + 1 > *capacity) {
+    *capacity = (*length + needed + 1) * 2;
+    *text = realloc(*text, *capacity);
+  }
+  if (*length > 0) {
+    (*text)[(*length)++] = ';';
+  }
+  strcpy(*text + *length, label);
+  *length += needed - 1;
+}
+
+int compareStacks(const void *a, const void *b) {
+  return strcmp(*(char **) a, *(char **) b);
+}
+
+void profileFinish(FILE *out) {
+  struct itimerval off;
+  memset(&off, 0, sizeof(off));
+  setitimer(ITIMER_PROF, &off, NULL);
+  profiling = 0;
+
+  // Turn each sample into its folded stack, then sort them so that equal
+  // stacks are next to each other and can be counted.
+  size_t count = 0;
+  for (size_t at = 0; at < sampleTop; at += (intptr_t) samples[at] + 1) {
+    count++;
+  }
+  char **stacks = malloc(sizeof(char *) * (count + 1));
+  size_t index = 0;
+  for (size_t at = 0; at < sampleTop; at += (intptr_t) samples[at] + 1) {
+    int depth = (intptr_t) samples[at];
+    char *text = NULL;
+    size_t length = 0;
+    size_t capacity = 0;
+    if (depth == 0) {
+      text = strdup("[top level]");
+    }
+    for (int i = 0; i < depth; i++) {
+      appendLabel(&text, &length, &capacity, samples[at + 1 + i]);
+    }
+    stacks[index++] = text;
+  }
+  qsort(stacks, count, sizeof(char *), compareStacks);
+
+  for (size_t i = 0; i < count;) {
+    size_t j = i;
+    while (j < count && !strcmp(stacks[j], stacks[i])) {
+      j++;
+    }
+    fprintf(out, "%s %zu\n", stacks[i], j - i);
+    i = j;
+  }
+  if (samplesDropped > 0) {
+    fprintf(stderr, "profile: %ld samples dropped, buffer full\n", samplesDropped);
+  }
+  for (size_t i = 0; i < count; i++) {
+    free(stacks[i]);
+  }
+  free(stacks);
+}
@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include "value.h"
+
+#ifndef _PROFILE
+#define _PROFILE
+
+// A sampling profiler. While it is on, eval and the VM keep a shadow stack of
+// the procedures being applied, and a SIGPROF timer copies that stack into a
+// buffer every millisecond of CPU time. At exit the samples are written out
+// as folded stacks, one line per distinct stack followed by how many samples
+// saw it, which is what flame graph tools read.
+//
+// A procedure is identified by its functionCode: the body tree for eval and
+// the CODE_TYPE value for the VM. Both are in the old space by the time they
+// run, so they never move, and the profiler keeps them alive so their
+// addresses are never reused. It is labelled with the name it was first
+// defined with, if any, and the line of its lambda.
+//
+// When the profiler is off its only cost is a test of profiling on each
+// closure application, and saving and restoring profileDepth around eval.
+
+extern int profiling;
+
+#define PROFILE_STACK_SIZE 4096
+
+// Deeper than PROFILE_STACK_SIZE, the depth is still counted but only the
+// outermost procedures are kept.
+extern Value *volatile profileStack[PROFILE_STACK_SIZE];
+extern volatile int profileDepth;
+
+// Turns the profiler on. Call this before reading the program, so that the
+// parser records where each lambda is.
+void profileStart();
+
+// Turns the profiler off and writes the folded stacks to out.
+void profileFinish(FILE *out);
+
+// Records the line of a lambda form. lambdaArgs is the part after lambda.
+void profileNoteSource(Value *lambdaArgs, int line);
+
+// Returns the line recorded for a lambda form, or 0.
+int profileSourceLine(Value *lambdaArgs);
+
+// Registers a procedure when a closure is made, if it is not known already.
+// eval passes the lambda form, and the VM the line the compiler recorded.
+void profileNoteLambda(Value *code, Value *lambdaArgs);
+void profileNoteCode(Value *code, int line);
+
+// Gives a procedure a name, unless it has one already.
+void profileNameCode(Value *code, char *name);
+
+// Enters the procedure code. A tail call replaces the procedure entered since
+// base, the depth when the current eval or execute began, if there is one,
+// the same way the call itself replaces it.
+static inline void profileEnter(Value *code, int base, int tail) {
+  int depth = profileDepth;
+  if (tail && depth > base) {
+    depth--;
+  }
+  if (depth < PROFILE_STACK_SIZE) {
+    profileStack[depth] = code;
+  }
+  profileDepth = depth + 1;
+}
+
+#endif
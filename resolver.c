@@ -0,0 +1,285 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include "resolver.h"
+#include "value.h"
+#include "linkedlist.h"
+#include "symbol.h"
+#include "gc.h"
+#include "interpreter.h"
+
+// The variables bound by one frame. Names are kept most recent first, so that
+// when a let binds the same name twice the later binding wins, as it would
+// have when frames were searched front to back; slots count from the oldest.
+typedef struct Scope {
+  Value *names;
+  int size;
+  struct Scope *parent;
+} Scope;
+
+void resolveExpr(Value **expr, Scope *scope);
+
+void addName(Scope *scope, Value *name) {
+  scope->names = cons(name, scope->names);
+  scope->size++;
+}
+
+int slotOf(Value *symbol, Scope *scope) {
+  int position = 0;
+  for (Value *names = scope->names; names != NULL_VALUE; names = cdr(names)) {
+    if (car(names) == symbol) {
+      return scope->size - 1 - position;
+    }
+    position++;
+  }
+  return -1;
+}
+
+// Returns a LOCAL_TYPE reference for symbol, or NULL if it is not bound by any
+// enclosing scope and so must be global.
+Value *localRef(Value *symbol, Scope *scope) {
+  int depth = 0;
+  while (scope != NULL) {
+    int slot = slotOf(symbol, scope);
+    if (slot >= 0) {
+      Value *ref = gcValue();
+      ref->type = LOCAL_TYPE;
+      ref->ref.depth = depth;
+      ref->ref.slot = slot;
+      ref->ref.name = symbol;
+      return ref;
+    }
+    scope = scope->parent;
+    depth++;
+  }
+  return NULL;
+}
+
+void resolveEach(Value *list, Scope *scope) {
+  while (typeOf(list) == CONS_TYPE) {
+    resolveExpr(&list->c.car, scope);
+    list = cdr(list);
+  }
+}
+
+syntaxType syntaxOfForm(Value *expr) {
+  if (typeOf(expr) == CONS_TYPE && typeOf(car(expr)) == SYMBOL_TYPE) {
+    return car(expr)->syntax;
+  }
+  return NO_SYNTAX;
+}
+
+// Finds the names defined by expr without entering a new scope, adding any
+// that scope does not already bind to the defined list.
+Value *collectDefines(Value *expr, Scope *scope, Value *defined) {
+  if (typeOf(expr) != CONS_TYPE) {
+    return defined;
+  }
+  switch (syntaxOfForm(expr)) {
+    case QUOTE_SYNTAX:
+    case LAMBDA_SYNTAX:
+    case LET_STAR_SYNTAX:
+    case LETREC_SYNTAX:
+      return defined;
+    case LET_SYNTAX:
+      if (typeOf(cdr(expr)) != CONS_TYPE || car(cdr(expr)) != NULL_VALUE) {
+        return defined;
+      }
+      break;
+    case DEFINE_SYNTAX: {
+      Value *args = cdr(expr);
+      if (typeOf(args) == CONS_TYPE && typeOf(car(args)) == SYMBOL_TYPE &&
+          slotOf(car(args), scope) < 0) {
+        Value *known = defined;
+        while (known != NULL_VALUE && car(known) != car(args)) {
+          known = cdr(known);
+        }
+        if (known == NULL_VALUE) {
+          defined = cons(car(args), defined);
+        }
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  for (Value *list = expr; typeOf(list) == CONS_TYPE; list = cdr(list)) {
+    defined = collectDefines(car(list), scope, defined);
+  }
+  return defined;
+}
+
+// Resolves a body, the list of expressions held in *body, in scope. Internal
+// defines cannot add slots to a frame that already exists, so a body that has
+// them is wrapped in a let binding each defined name, and the defines become
+// set!s of those slots:
+//   (define x e) ... => (let ((x <void>)) (set! x e) ...)
+void resolveBody(Value **body, Scope *scope) {
+  Value *defined = NULL_VALUE;
+  for (Value *list = *body; typeOf(list) == CONS_TYPE; list = cdr(list)) {
+    defined = collectDefines(car(list), scope, defined);
+  }
+
+  if (defined != NULL_VALUE) {
+    Value *placeholder = VOID_VALUE;
+    Value *bindings = NULL_VALUE;
+    for (; defined != NULL_VALUE; defined = cdr(defined)) {
+      Value *binding = cons(car(defined), cons(placeholder, NULL_VALUE));
+      bindings = cons(binding, bindings);
+    }
+    Value *let = cons(intern("let"), cons(bindings, *body));
+    *body = cons(let, NULL_VALUE);
+  }
+  resolveEach(*body, scope);
+}
+
+void resolveLetStar(Value *bindings, Value **body, Scope *scope) {
+  if (typeOf(bindings) != CONS_TYPE) {
+    resolveBody(body, scope);
+    return;
+  }
+  Value *binding = car(bindings);
+  if (typeOf(binding) != CONS_TYPE || typeOf(car(binding)) != SYMBOL_TYPE) {
+    return;
+  }
+  resolveEach(cdr(binding), scope);
+  Scope inner = {NULL_VALUE, 0, scope};
+  addName(&inner, car(binding));
+  resolveLetStar(cdr(bindings), body, &inner);
+}
+
+void resolveExpr(Value **expr, Scope *scope) {
+  Value *tree = *expr;
+  if (typeOf(tree) == SYMBOL_TYPE) {
+    Value *ref = localRef(tree, scope);
+    if (ref != NULL) {
+      *expr = ref;
+    }
+    return;
+  } else if (typeOf(tree) != CONS_TYPE) {
+    return;
+  }
+
+  Value *args = cdr(tree);
+  if (typeOf(args) != CONS_TYPE) {
+    // Nothing to resolve, or malformed; eval will complain if need be.
+    if (syntaxOfForm(tree) == NO_SYNTAX) {
+      resolveExpr(&tree->c.car, scope);
+    }
+    return;
+  }
+
+  switch (syntaxOfForm(tree)) {
+    case QUOTE_SYNTAX:
+      return;
+    case LAMBDA_SYNTAX: {
+      Scope inner = {NULL_VALUE, 0, scope};
+      for (Value *params = car(args); typeOf(params) == CONS_TYPE; params = cdr(params)) {
+        addName(&inner, car(params));
+      }
+      resolveBody(&args->c.cdr, &inner);
+      return;
+    }
+    case LET_SYNTAX: {
+      if (car(args) == NULL_VALUE) {
+        // (let () ...) does not create a frame.
+        resolveEach(cdr(args), scope);
+        return;
+      }
+      Scope inner = {NULL_VALUE, 0, scope};
+      for (Value *bindings = car(args); typeOf(bindings) == CONS_TYPE; bindings = cdr(bindings)) {
+        Value *binding = car(bindings);
+        if (typeOf(binding) != CONS_TYPE || typeOf(car(binding)) != SYMBOL_TYPE) {
+          return;
+        }
+        resolveEach(cdr(binding), scope);
+        addName(&inner, car(binding));
+      }
+      resolveBody(&args->c.cdr, &inner);
+      return;
+    }
+    case LET_STAR_SYNTAX:
+      resolveLetStar(car(args), &args->c.cdr, scope);
+      return;
+    case LETREC_SYNTAX: {
+      Scope inner = {NULL_VALUE, 0, scope};
+      for (Value *bindings = car(args); typeOf(bindings) == CONS_TYPE; bindings = cdr(bindings)) {
+        Value *binding = car(bindings);
+        if (typeOf(binding) != CONS_TYPE || typeOf(car(binding)) != SYMBOL_TYPE) {
+          return;
+        }
+        addName(&inner, car(binding));
+      }
+      for (Value *bindings = car(args); typeOf(bindings) == CONS_TYPE; bindings = cdr(bindings)) {
+        resolveEach(cdr(car(bindings)), &inner);
+      }
+      resolveBody(&args->c.cdr, &inner);
+      return;
+    }
+    case DEFINE_SYNTAX:
+      if (scope != NULL) {
+        // resolveBody has already given the name a slot.
+        tree->c.car = intern("set!");
+        resolveEach(args, scope);
+      } else {
+        resolveEach(cdr(args), scope);
+      }
+      return;
+    case SET_SYNTAX:
+      resolveEach(args, scope);
+      return;
+    case COND_SYNTAX:
+      for (; typeOf(args) == CONS_TYPE; args = cdr(args)) {
+        Value *clause = car(args);
+        if (typeOf(clause) != CONS_TYPE) {
+          continue;
+        }
+        if (syntaxOfForm(clause) == ELSE_SYNTAX) {
+          resolveEach(cdr(clause), scope);
+        } else {
+          resolveEach(clause, scope);
+        }
+      }
+      return;
+    case NO_SYNTAX:
+      resolveEach(tree, scope);
+      return;
+    default:
+      resolveEach(args, scope);
+      return;
+  }
+}
+
+// Rejects a form that is not made of proper lists. The reader accepts dotted
+// pairs, but only as quoted data; everything that walks code assumes every
+// list ends in '(). A lambda's parameter list is reported on its own, since
+// rest parameters are the one dotted list that means something as code.
+void checkProperForm(Value *tree) {
+  if (typeOf(tree) != CONS_TYPE) {
+    return;
+  }
+  if (syntaxOfForm(tree) == LAMBDA_SYNTAX && typeOf(cdr(tree)) == CONS_TYPE) {
+    Value *params = car(cdr(tree));
+    while (typeOf(params) == CONS_TYPE) {
+      params = cdr(params);
+    }
+    if (params != NULL_VALUE) {
+      evaluationError("lambda: rest parameters are not supported");
+    }
+  }
+  int quoted = syntaxOfForm(tree) == QUOTE_SYNTAX;
+  Value *list = tree;
+  for (; typeOf(list) == CONS_TYPE; list = cdr(list)) {
+    if (!quoted) {
+      checkProperForm(car(list));
+    }
+  }
+  if (list != NULL_VALUE) {
+    evaluationError("resolve: dotted pair in code");
+  }
+}
+
+// Resolves one top-level form in place.
+void resolve(Value **expr) {
+  checkProperForm(*expr);
+  resolveExpr(expr, NULL);
+}
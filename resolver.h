@@ -0,0 +1,12 @@
+#include "value.h"
+
+#ifndef _RESOLVER
+#define _RESOLVER
+
+// Rewrites a freshly parsed top-level form in place so that every reference to
+// a lambda or let variable becomes a LOCAL_TYPE (depth, slot) coordinate.
+// Anything not bound by an enclosing form is left as a symbol and looked up in
+// the global frame at run time.
+void resolve(Value **expr);
+
+#endif
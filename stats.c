@@ -0,0 +1,3 @@
+#include "stats.h"
+
+Stats stats;
@@ -0,0 +1,27 @@
+#include "value.h"
+
+#ifndef _STATS
+#define _STATS
+
+// Counts of what the interpreter does, reported at exit by --stats and from
+// Scheme by (interpreter-stats). They are always kept: each is a single
+// increment on a path that does much more work than that. Values and frames
+// come from the collector, which counts them itself; they are reported with
+// these as gc-objects and gc-bytes.
+typedef struct Stats {
+  long evalSteps;                      // times round eval's loop
+  long forms[ELSE_SYNTAX + 1];         // evaluations of each special form by
+                                       // eval, with calls under NO_SYNTAX
+  long closureApplications;
+  long *primitiveCalls;                // by index in the primitive table
+  long tallocCalls;                    // arena allocations, which are mostly
+  long tallocBytes;                    // the collector's chunks
+  long framesCreated;
+  long globalLookups;
+  long localLookups;
+  long framesWalked;                   // by local lookups, to reach the frame
+} Stats;
+
+extern Stats stats;
+
+#endif
@@ -0,0 +1,106 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "symbol.h"
+#include "value.h"
+#include "talloc.h"
+#include "gc.h"
+
+// Open-addressing hash set of every symbol seen so far, keyed by name. The
+// table is kept at most half full and doubles when it gets there.
+Value **symbolTable;
+size_t symbolCapacity;
+size_t symbolCount;
+
+// Names that are tagged with a syntaxType when first interned.
+struct {
+  char *name;
+  syntaxType syntax;
+} specialForms[] = {
+  {"if", IF_SYNTAX}, {"let", LET_SYNTAX}, {"quote", QUOTE_SYNTAX},
+  {"define", DEFINE_SYNTAX}, {"lambda", LAMBDA_SYNTAX},
+  {"let*", LET_STAR_SYNTAX}, {"letrec", LETREC_SYNTAX},
+  {"cond", COND_SYNTAX}, {"set!", SET_SYNTAX}, {"begin", BEGIN_SYNTAX},
+  {"and", AND_SYNTAX}, {"or", OR_SYNTAX}, {"else", ELSE_SYNTAX},
+};
+
+syntaxType syntaxOf(char *name) {
+  int count = sizeof(specialForms) / sizeof(specialForms[0]);
+  for (int i = 0; i < count; i++) {
+    if (!strcmp(specialForms[i].name, name)) {
+      return specialForms[i].syntax;
+    }
+  }
+  return NO_SYNTAX;
+}
+
+char *syntaxName(syntaxType syntax) {
+  int count = sizeof(specialForms) / sizeof(specialForms[0]);
+  for (int i = 0; i < count; i++) {
+    if (specialForms[i].syntax == syntax) {
+      return specialForms[i].name;
+    }
+  }
+  return NULL;
+}
+
+// FNV-1a.
+uint32_t hashName(char *name, int length) {
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < length; i++) {
+    hash = (hash ^ (unsigned char) name[i]) * 16777619u;
+  }
+  return hash;
+}
+
+void insertSymbol(Value **table, size_t capacity, Value *symbol) {
+  size_t slot = hashName(symbol->s, symbol->length) & (capacity - 1);
+  while (table[slot] != NULL) {
+    slot = (slot + 1) & (capacity - 1);
+  }
+  table[slot] = symbol;
+}
+
+void growSymbolTable() {
+  size_t capacity = symbolCapacity == 0 ? 256 : symbolCapacity * 2;
+  Value **table = talloc(sizeof(Value *) * capacity);
+  memset(table, 0, sizeof(Value *) * capacity);
+  for (size_t i = 0; i < symbolCapacity; i++) {
+    if (symbolTable[i] != NULL) {
+      insertSymbol(table, capacity, symbolTable[i]);
+    }
+  }
+  symbolTable = table;
+  symbolCapacity = capacity;
+}
+
+Value *internLength(char *name, int length) {
+  if (2 * (symbolCount + 1) > symbolCapacity) {
+    growSymbolTable();
+  }
+
+  size_t slot = hashName(name, length) & (symbolCapacity - 1);
+  while (symbolTable[slot] != NULL) {
+    Value *symbol = symbolTable[slot];
+    if (symbol->length == length && !memcmp(symbol->s, name, length)) {
+      return symbol;
+    }
+    slot = (slot + 1) & (symbolCapacity - 1);
+  }
+
+  // The name is stored inline, just past the symbol's Value.
+  Value *symbol = gcAllocPermanent(sizeof(Value) + length + 1, GC_VALUE);
+  symbol->type = SYMBOL_TYPE;
+  symbol->s = (char *) (symbol + 1);
+  memcpy(symbol->s, name, length);
+  symbol->s[length] = '\0';
+  symbol->length = length;
+  symbol->syntax = syntaxOf(symbol->s);
+  symbolTable[slot] = symbol;
+  symbolCount++;
+  return symbol;
+}
+
+Value *intern(char *name) {
+  return internLength(name, strlen(name));
+}
@@ -0,0 +1,19 @@
+#include "value.h"
+
+#ifndef _SYMBOL
+#define _SYMBOL
+
+// Returns the unique SYMBOL_TYPE value with the given name, creating it the
+// first time the name is seen. Symbols are never collected, so two symbols
+// are the same symbol exactly when they are the same pointer. Symbols naming
+// a special form come back tagged with its syntaxType.
+Value *intern(char *name);
+
+// Like intern, but for a name that is the first length bytes at name, which
+// need not be NUL-terminated.
+Value *internLength(char *name, int length);
+
+// Returns the name of a special form, or NULL for NO_SYNTAX.
+char *syntaxName(syntaxType syntax);
+
+#endif
@@ -1,68 +1,113 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
-#include "linkedlist.h"
+#include <stddef.h>
 #include <assert.h>
 #include <string.h>
 #include "talloc.h"
 #include "value.h"
+#include "stats.h"
+
+// Memory is carved out of large chunks with a bump pointer instead of asking
+// malloc for every object. Requests too big to share a chunk get a chunk of
+// their own, so no allocation is ever split across chunks.
+#define CHUNK_SIZE (64 * 1024)
+#define ALIGNMENT (sizeof(max_align_t))
+
+typedef struct Chunk {
+  struct Chunk *next;
+  struct Chunk *prev;
+  size_t used;
+  size_t size;
+  max_align_t data[];
+} Chunk;
+
+Chunk *activeChunk;  // chunk currently being bumped into
+Chunk *fullChunks;   // retired chunks
+Chunk *largeChunks;  // one chunk per large object, doubly linked for trelease
+
+// Rounds size up so that every pointer handed out stays aligned.
+size_t alignSize(size_t size) {
+  return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
 
-typedef struct Value Value;
-
-Value *activeList;  //global variable
-
-// Replacement for malloc that stores the pointers allocated. It should store
-// the pointers in some kind of list; a linked list would do fine, but insert
-// here whatever code you'll need to do so; don't call functions in the
-// pre-existing linkedlist.h. Otherwise you'll end up with circular
-// dependencies, since you're going to modify the linked list to use talloc.
+Chunk *newChunk(size_t size) {
+  Chunk *chunk = malloc(sizeof(Chunk) + size);
+  if (chunk == NULL) {
+    printf("Memory error: out of memory\n");
+    texit(1);
+  }
+  chunk->next = NULL;
+  chunk->prev = NULL;
+  chunk->used = 0;
+  chunk->size = size;
+  return chunk;
+}
 
+// Replacement for malloc that stores the pointers allocated. Small objects are
+// bumped out of the active chunk; once it fills up the chunk is retired onto
+// fullChunks and a fresh one takes its place. Objects of at least
+// TALLOC_LARGE_OBJECT bytes get a dedicated chunk.
 void *talloc(size_t size) {
-  if (activeList == NULL) {
-      Value *null = malloc(sizeof(Value));
-      null->type = NULL_TYPE;
-      activeList = null;
+  size = alignSize(size == 0 ? 1 : size);
+  stats.tallocCalls++;
+  stats.tallocBytes += size;
+
+  if (size >= TALLOC_LARGE_OBJECT) {
+    Chunk *large = newChunk(size);
+    large->used = size;
+    large->next = largeChunks;
+    if (largeChunks != NULL) {
+      largeChunks->prev = large;
+    }
+    largeChunks = large;
+    return large->data;
   }
 
-  Value *newPointer = malloc(sizeof(Value)); 
-  newPointer->type = PTR_TYPE;
-  void *newVal = malloc(size);
-  newPointer->p = newVal;
-
-  Value *newCons = malloc(sizeof(Value));
-  newCons->type = CONS_TYPE;
-
-  newCons->c.car = newPointer;
-  newCons->c.cdr = activeList;
-
-  activeList = newCons;
+  if (activeChunk == NULL || activeChunk->used + size > activeChunk->size) {
+    if (activeChunk != NULL) {
+      activeChunk->next = fullChunks;
+      fullChunks = activeChunk;
+    }
+    activeChunk = newChunk(CHUNK_SIZE);
+  }
 
+  void *newVal = (char *) activeChunk->data + activeChunk->used;
+  activeChunk->used += size;
   return newVal;
 }
 
-// Free all pointers allocated by talloc, as well as whatever memory you
-// allocated in lists to hold those pointers.
-
-//clear the pointer's p value first. 
-// Make temp variable for active list;
-//similar to clean up function in previous lab.
+// Give one large object back to malloc ahead of tfree.
+void trelease(void *ptr) {
+  Chunk *large = (Chunk *) ((char *) ptr - offsetof(Chunk, data));
+  if (large->prev != NULL) {
+    large->prev->next = large->next;
+  } else {
+    largeChunks = large->next;
+  }
+  if (large->next != NULL) {
+    large->next->prev = large->prev;
+  }
+  free(large);
+}
 
+// Free all pointers allocated by talloc. Only the chunks themselves were
+// malloc'd, so this is one free per chunk rather than one per object.
 void tfree() {
-  
-  Value *temp = activeList;
+  while (fullChunks != NULL) {
+    Chunk *temp = fullChunks;
+    fullChunks = fullChunks->next;
+    free(temp);
+  }
 
-  while (activeList != NULL && !isNull(activeList)) {
-    if (activeList->c.car != NULL && activeList->c.car->type == PTR_TYPE) {
-      free(activeList->c.car->p);
-    }
-    free(activeList->c.car);
-    temp = activeList;
-    activeList = activeList->c.cdr;
+  while (largeChunks != NULL) {
+    Chunk *temp = largeChunks;
+    largeChunks = largeChunks->next;
     free(temp);
   }
 
-  free(activeList);
-  activeList = NULL;
+  free(activeChunk);
+  activeChunk = NULL;
 }
 
 // Replacement for the C function "exit", that consists of two lines: it calls
@@ -72,4 +117,4 @@ void tfree() {
 void texit(int status) {
   tfree();
   exit(status);
-}
\ No newline at end of file
+}
@@ -4,15 +4,23 @@
 #ifndef _TALLOC
 #define _TALLOC
 
-// Replacement for malloc that stores the pointers allocated. It should store
-// the pointers in some kind of list; a linked list would do fine, but insert
-// here whatever code you'll need to do so; don't call functions in the
-// pre-existing linkedlist.h. Otherwise you'll end up with circular
-// dependencies, since you're going to modify the linked list to use talloc.
+// Requests of at least this many bytes bypass the shared chunks and get a
+// chunk of their own.
+#define TALLOC_LARGE_OBJECT (16 * 1024)
+
+// Replacement for malloc that stores the pointers allocated. Memory comes from
+// a bump-pointer arena: objects are carved out of large chunks, so an
+// allocation is usually just a pointer increment. Nothing is released until
+// tfree.
 void *talloc(size_t size);
 
-// Free all pointers allocated by talloc, as well as whatever memory you
-// allocated in lists to hold those pointers.
+// Release a single object early. Only valid for pointers returned by talloc
+// for requests of at least TALLOC_LARGE_OBJECT bytes; smaller objects share
+// their chunk and live until tfree.
+void trelease(void *ptr);
+
+// Free all pointers allocated by talloc. The arena is released a chunk at a
+// time, so this costs one free per chunk rather than one per object.
 void tfree();
 
 // Replacement for the C function "exit", that consists of two lines: it calls
@@ -0,0 +1,27 @@
+(define big 4611686018427387903)
+(+ big 1)
+(- (- 0 big) 2)
+(* 3037000500 3037000500)
+(* -99999999999 99999999999)
+(define v (vector 'a 'b 'c))
+(vector-ref v (- (+ big 2) big))
+(vector-ref v (/ (* big 4) (* big 2)))
+(- (* big big) (* big big))
+(+ (- 0 big 1) big 1)
+(define a 75774637064330445294039402907794345461576829490410853724457712707707179170236508069578135118130601062432903831124660677740003648613161417626322668362572636074941147387397827811507170858215646133730035699304060283388480998379752721301541202913539612171092223605166419693575605313660936850865026352606067020239499600188025991984729649968129044475146497)
+(define b 3011564743407031629356914052569453238081400814311775001461569763934232265120326144655635370805078686918238302024357072357655346060362039920918393640705455330842455131704346824805603515556843913991926828923923978332694013584309101122066543822559696838462516675263696923681968610893755719824119559849036146385167385458578135031974852591659722)
+(* a b)
+(* (- 0 a) b)
+(* a a a)
+(= (/ (* a b) b) a)
+(/ (* a a b) (* a b))
+(modulo (+ (* a b) 12345) b)
+(modulo (- 0 (+ (* a b) 12345)) b)
+(modulo (+ (* a b) 12345) (- 0 b))
+(modulo (* a a) (- 0 b))
+(modulo (- 0 (* a a)) b)
+(modulo -7 2)
+(modulo 7 -2)
+(modulo (- 0 a) 1000000007)
+(+ (* 1000000000 1000000000 1000000000 1000000000) 7)
+(- 0 (* 1000000000 1000000000 1000000000 1000000001))
@@ -0,0 +1,6 @@
+"a\tb"
+"line\nbreak"
+"say \"hi\""
+"back\\slash"
+"raw	tab"
+(cons "x\ty" (quote ()))
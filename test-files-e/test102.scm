@@ -0,0 +1,4 @@
+(cond (#t))
+(cond (#f 1) (else))
+(cond ((= 1 1)) (else 2))
+(cond (#f) (else 3))
@@ -0,0 +1,13 @@
+(define n (/ 0.0 0.0))
+(= n n)
+(= n 1)
+(< n 1)
+(> n 1)
+(< 1 n)
+(> 100000000000000000000 n)
+(= 1 1.0)
+(< 1 2 3)
+(< 1 3 2)
+(> 3 2.5 2)
+(= 100000000000000000000 100000000000000000000)
+(< -100000000000000000000 100000000000000000000)
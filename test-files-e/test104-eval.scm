@@ -0,0 +1,16 @@
+(define nth
+  (lambda (n list)
+    (if (= n 0) (car list) (nth (- n 1) (cdr list)))))
+(define count
+  (lambda (n)
+    (if (= n 0) 0 (count (- n 1)))))
+(define before (interpreter-stats))
+(count 10)
+(define after (interpreter-stats))
+(define change
+  (lambda (n)
+    (cons (car (nth n after)) (- (cdr (nth n after)) (cdr (nth n before))))))
+(define change-in-if
+  (- (cdr (car (cdr (nth 2 after)))) (cdr (car (cdr (nth 2 before))))))
+change-in-if
+(cdr (change 1))
@@ -0,0 +1,7 @@
+(let () 1 2)
+(define x 5)
+(let () (define y 3) (+ x y))
+(let ((a 1 2)) a)
+(let* ((a 1 'ignored) (b (+ a 1) 'ignored)) (+ a b))
+(let () x)
+(letrec ((f (lambda () 1) 2)) (f))
@@ -0,0 +1,22 @@
+(define counter 0)
+(define bump (lambda () (set! counter (+ counter 1))))
+(bump)
+(bump)
+counter
+(define f
+  (lambda (x)
+    (begin
+      (define y (* x 2))
+      (define g (lambda (z) (+ y z)))
+      (g x))))
+(f 5)
+(let ((x 1) (x 2)) x)
+(letrec ((even? (lambda (n) (if (= n 0) #t (odd? (- n 1)))))
+         (odd? (lambda (n) (if (= n 0) #f (even? (- n 1))))))
+  (even? 10))
+(let* ((a 1) (b (+ a 1)) (c (* b 3))) (cons a (cons b c)))
+(define shadow (lambda (car) (cons car 1)))
+(shadow 3)
+(let ((if 5)) (if #t 1 2))
+(cond ((= 1 2) (quote a)) (else (quote b)))
+((lambda (x y) (- x y)) 10 3)
@@ -0,0 +1,11 @@
+(define v (make-vector 3 0))
+(vector-set! v 1 'b)
+v
+(vector-ref v 1)
+(vector-length v)
+(vector 1 (cons 2 3) #(4))
+(vector->list (list->vector (quote (a b c))))
+(vector-fill! v 5)
+v
+'#(x "y" 1.5)
+(vector-ref v 3)
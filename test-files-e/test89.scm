@@ -0,0 +1,39 @@
+(define v (make-f64vector 10 1.5))
+(f64vector-set! v 3 4)
+v
+(f64vector-ref v 3)
+(f64vector-length v)
+(define w (f64vector 1 2 3 4 5 6 7 8 9 10))
+(f64vector-add v w)
+(f64vector-mul v w)
+(f64vector-scale w 0.5)
+(f64vector-dot v w)
+(f64vector-sum w)
+(f64vector-min w)
+(f64vector-max w)
+(define s (s64vector 5 -3 9223372036854775807 9223372036854775807 2 7))
+s
+(s64vector-sum s)
+(s64vector-min s)
+(s64vector-max s)
+(s64vector-set! s 0 100)
+(s64vector-ref s 0)
+(s64vector-length (make-s64vector 3 2))
+(define n (/ 0.0 0.0))
+(f64vector-min (f64vector 1 2 3 4 5 6 7 8 n))
+(f64vector-min (f64vector n 1 2 3 4 5 6 7 8))
+(f64vector-min (f64vector 1 n 2 3 4 5 6 7 8))
+(f64vector-max (f64vector 1 2 3 4 5 6 7 8 n))
+(f64vector-max (f64vector 1 2 3 n 4 5 6 7 8))
+(f64vector-max (f64vector n))
+(f64vector-min (f64vector 3 -2 7))
+(define s (s64vector 1 -2 3 4 5 6 7))
+(define t (s64vector 10 20 30 40 50 60 70))
+(s64vector-add s t)
+(s64vector-mul s t)
+(s64vector-scale s -3)
+(s64vector-dot s t)
+(define big (s64vector 9223372036854775807 9223372036854775807 -9223372036854775807 5))
+(s64vector-dot big big)
+(s64vector-dot big (s64vector 2 2 1 1))
+(s64vector-add (s64vector 1 2 3 4 5) (s64vector 1 2 3 4 9223372036854775807))
@@ -0,0 +1,50 @@
+(define h (make-hash-table))
+(hash-table-set! h 'apple 3)
+(hash-table-set! h "pear" 5)
+(hash-table-set! h (cons 1 (cons 2 (quote ()))) 'pair)
+(hash-table-set! h 2.5 'half)
+(hash-table-set! h 100000000000000000000000 'big)
+(hash-table-ref h 'apple)
+(hash-table-ref h "pear")
+(hash-table-ref h (cons 1 (cons 2 (quote ()))))
+(hash-table-ref h 2.5)
+(hash-table-ref h 100000000000000000000000)
+(hash-table-ref h 'missing 0)
+(hash-table-contains? h 'apple)
+(hash-table-count h)
+(hash-table-set! h 'apple 4)
+(hash-table-ref h 'apple)
+(hash-table-delete! h 'apple)
+(hash-table-contains? h 'apple)
+(hash-table-count h)
+h
+(define e (make-hash-table 'eq?))
+(hash-table-set! e "pear" 1)
+(hash-table-ref e "pear" #f)
+(define fill
+  (lambda (i n)
+    (if (< i n)
+        (begin (hash-table-set! e (* i 7) i) (fill (+ i 1) n)) #t)))
+(fill 0 5000)
+(define drop
+  (lambda (i n)
+    (if (< i n)
+        (begin (hash-table-delete! e (* i 7)) (drop (+ i 2) n)) #t)))
+(drop 0 5000)
+(hash-table-count e)
+(define check
+  (lambda (i n total)
+    (if (< i n)
+        (check (+ i 1) n (+ total (hash-table-ref e (* i 7) 0)))
+        total)))
+(check 0 5000 0)
+(hash-table->alist (let ((t (make-hash-table))) (hash-table-set! t 1 2) t))
+(define z (make-hash-table))
+(hash-table-set! z 0.0 'zero)
+(hash-table-ref z -0.0 #f)
+(hash-table-set! z -0.0 'negative-zero)
+(hash-table-count z)
+(hash-table-set! z (/ 0.0 0) 'nan)
+(hash-table-set! z (/ 0.0 0) 'nan-again)
+(hash-table-count z)
+(hash-table-ref z (/ 0.0 0) #f)
@@ -0,0 +1,22 @@
+(define stats (interpreter-stats))
+(car (car stats))
+(car (car (cdr (cdr stats))))
+(car (car (cdr (car (cdr (cdr stats))))))
+(define nth
+  (lambda (n list)
+    (if (= n 0) (car list) (nth (- n 1) (cdr list)))))
+(define count
+  (lambda (n)
+    (if (= n 0) 0 (count (- n 1)))))
+(define before (interpreter-stats))
+(count 10)
+(define after (interpreter-stats))
+(define change
+  (lambda (n)
+    (cons (car (nth n after)) (- (cdr (nth n after)) (cdr (nth n before))))))
+(change 3)
+(change 4)
+(change 10)
+(car (nth 6 after))
+(> (cdr (change 6)) 0)
+(interpreter-stats 1)
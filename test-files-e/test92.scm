@@ -0,0 +1,13 @@
+[+ 1 2]
+(let ([a 1] [b 2]) (cons a b))
+'x
+''x
+'(a . b)
+(car '(a . b))
+(cdr '(a . b))
+'(1 2 . 3)
+(cdr (cdr '(1 2 . 3)))
+'((a . 1) [b . 2])
+(quote (x . (y . (z))))
+'#(1 (2 . 3))
+(car . 1)
@@ -0,0 +1,3 @@
+(define x '(1 . 2))
+(cdr x)
+(if #t . 1)
@@ -0,0 +1,3 @@
+(define x '(1 . 2))
+(cdr x)
+(1 . 2)
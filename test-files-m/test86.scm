@@ -0,0 +1,13 @@
+(define make-counter
+  (lambda ()
+    (let ((n 0))
+      (lambda () (begin (set! n (+ n 1)) n)))))
+(define c (make-counter))
+(define count (lambda (n) (if (= n 0) 0 (+ 1 (count (- n 1))))))
+(define loop
+  (lambda (i)
+    (if (= i 0)
+        (c)
+        (begin (c) (count 500) (loop (- i 1))))))
+(loop 400)
+(count 500)
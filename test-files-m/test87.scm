@@ -0,0 +1,13 @@
+(define loop
+  (lambda (n)
+    (if (= n 0)
+        'done
+        (cond ((< n 0) 'negative)
+              (else
+               (begin
+                 n
+                 (let ((m (- n 1)))
+                   (let* ((k m) (j k))
+                     (letrec ((next (lambda (i) (loop i))))
+                       (next j))))))))))
+(loop 50000)
@@ -3,22 +3,91 @@
 #include <stdbool.h>
 #include <string.h>
 #include <ctype.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "linkedlist.h"
 #include <assert.h>
 #include <string.h>
 #include "talloc.h"
+#include "gc.h"
+#include "symbol.h"
+#include "bignum.h"
 #include "value.h"
 
-// skips comment
-int commentCheck(char charNext) {
-    while (charNext != '\n' && charNext != EOF) {
-        charNext = (char)fgetc(stdin);
+// The program text read so far and how far the tokenizer has got through it.
+// A regular file is mapped whole rather than copied. Anything else, such as a
+// pipe or a terminal, is read on demand into large blocks, so a form can be
+// tokenized as soon as it has arrived. A block that fills up is kept, since
+// string tokens point straight into it, and the start of any token still
+// being scanned is copied over into the next one.
+char *input;
+size_t inputLength;
+size_t inputCapacity;
+size_t position;
+size_t tokenStart;
+int inputMapped;
+int inputEnded;
+
+// Newlines passed so far, for tokenLine.
+int line = 1;
+int tokenLine;
+
+#define READ_BLOCK (64 * 1024)
+
+void mapInput() {
+  struct stat info;
+  if (fstat(STDIN_FILENO, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+    void *mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, STDIN_FILENO, 0);
+    if (mapped != MAP_FAILED) {
+      input = mapped;
+      inputLength = info.st_size;
+      inputCapacity = info.st_size;
+      inputMapped = 1;
     }
-    if (charNext == EOF) {
-        return 1;
-    } else {
-        return 0;
+  }
+}
+
+// Reads more of stdin, returning 0 if there is no more.
+int fillInput() {
+  if (inputMapped || inputEnded) {
+    return 0;
+  }
+  if (inputLength == inputCapacity) {
+    size_t kept = inputLength - tokenStart;
+    size_t capacity = kept * 2 > READ_BLOCK ? kept * 2 : READ_BLOCK;
+    char *block = talloc(capacity);
+    if (kept > 0) {
+      memcpy(block, input + tokenStart, kept);
     }
+    input = block;
+    inputLength = kept;
+    inputCapacity = capacity;
+    position -= tokenStart;
+    tokenStart = 0;
+  }
+  ssize_t count = read(STDIN_FILENO, input + inputLength, inputCapacity - inputLength);
+  if (count <= 0) {
+    inputEnded = 1;
+    return 0;
+  }
+  inputLength += count;
+  return 1;
+}
+
+// The next character, without consuming it, or EOF at the end of the input.
+int peekChar() {
+  if (position == inputLength && !fillInput()) {
+    return EOF;
+  }
+  return (unsigned char) input[position];
+}
+
+// skips comment
+void commentCheck() {
+  while (peekChar() != '\n' && peekChar() != EOF) {
+    position++;
+  }
 }
 
 // checks to see if it is a symbol
@@ -35,195 +104,225 @@ int isSymbol(char charNext) {
   return 0;
 }
 
+// Whether a character ends the symbol or number before it.
+int isDelimiter(int charNext) {
+  return charNext == EOF || charNext == ' ' || charNext == '\n' ||
+         charNext == '(' || charNext == ')' ||
+         charNext == '[' || charNext == ']';
+}
+
 // boolean
 Value *boolHelp() {
-  char charNext = (char)fgetc(stdin);
-  Value *newToken = talloc(sizeof(Value));
-  newToken->type = BOOL_TYPE;
-
-  int *Token = talloc(sizeof(int) * 2);
-  if (charNext == 't') {
-    Token [0] = 1;
-    Token [1] = '\0';
-    newToken->i = *Token;
-  } else if (charNext == 'f') {
-    Token [0] = 0;
-    Token [1] = '\0';
-    newToken->i = *Token;
-  } else {
+  int charNext = peekChar();
+  if (charNext != 't' && charNext != 'f') {
     printf("Syntax error: Boolean untokenizeable \n");
     texit(0);
   }
+  position++;
 
-  return newToken;
+  return makeBool(charNext == 't');
 }
 
-// string
+// string, without its quotes. Without escapes it is a slice of the input;
+// with them it is a copy sized to the decoded text.
 Value *stringHelp() {
-  char charNext = (char)fgetc(stdin);
-  char *string = talloc(301);
-  int i = 1;
-  string [0] = '"';
-
-  while (charNext != '"') {
-    string[i] = charNext;
-    i++;
-    charNext = (char)fgetc(stdin);
+  int escaped = 0;
+  while (peekChar() != '"') {
+    if (peekChar() == EOF) {
+      printf("Syntax error: unterminated string\n");
+      texit(0);
+    }
+    if (peekChar() == '\\') {
+      escaped = 1;
+      position++;
+      if (peekChar() == EOF) {
+        continue;
+      }
+    }
+    if (peekChar() == '\n') {
+      line++;
+    }
+    position++;
+  }
+  position++;
+
+  char *text = input + tokenStart + 1;
+  int length = position - tokenStart - 2;
+  if (escaped) {
+    char *decoded = talloc(length);
+    int decodedLength = 0;
+    for (int i = 0; i < length; i++) {
+      char next = text[i];
+      if (next == '\\') {
+        next = text[++i];
+        if (next == 'n') {
+          next = '\n';
+        } else if (next == 't') {
+          next = '\t';
+        }
+      }
+      decoded[decodedLength++] = next;
+    }
+    text = decoded;
+    length = decodedLength;
   }
 
-  string [i] = '"';
-  string[i+1] = '\0';
-  Value *newToken = talloc(sizeof(Value));
+  Value *newToken = gcValue();
   newToken->type = STR_TYPE;
-  newToken->s = string;
+  newToken->s = text;
+  newToken->length = length;
 
   return newToken;
 }
 
 // symbol help
-Value *symbolHelp(char charNext) {
-  char *symbol = talloc(301);
-  int i = 0;
-
-  while (charNext != EOF && charNext != ' ' && charNext != '\n' && charNext != '(' && charNext != ')') {
-    symbol[i] = charNext;
-    i++;
-    charNext = (char)fgetc(stdin);
-  }
+Value *symbolHelp() {
+  int charNext = peekChar();
 
-  symbol[i] = '\0';
-  Value *newToken = talloc(sizeof(Value));
-  newToken->type = SYMBOL_TYPE;
-  newToken->s = symbol;
+  while (!isDelimiter(charNext)) {
+    position++;
+    charNext = peekChar();
+  }
 
-  fseek(stdin, -1L, SEEK_CUR);
-  return newToken;
+  return internLength(input + tokenStart, position - tokenStart);
 }
 
 // int / double
 Value *numHelp(char charNext) {
-    char *number = talloc(301);
-    int isDouble = 0;
-    int i = 0;
+    int isDouble = charNext == '.';
 
     if (charNext == '+' || charNext == '-') {
-      number[0] = charNext;
-      i++;
-      charNext = (char)fgetc(stdin);
-
-      if (!isdigit(charNext)) {
-        charNext = fseek(stdin, -1L, SEEK_CUR);
-        charNext = fseek(stdin, -1L, SEEK_CUR);
-        charNext = (char)fgetc(stdin);
-        return symbolHelp(charNext);
+      if (!isdigit(peekChar())) {
+        return symbolHelp();
       }
     }
 
-    while (isdigit(charNext) || charNext == '.') {
-        if (charNext == '.') {
+    while (isdigit(peekChar()) || peekChar() == '.') {
+        if (peekChar() == '.') {
             isDouble = 1;
         }
-        number[i] = charNext;
-        i++;
-        charNext = (char)fgetc(stdin);
+        position++;
     }
 
-    number[i] = '\0';
+    // strtod needs a terminated copy, but only of the digits.
+    char digits[64];
+    size_t length = position - tokenStart;
+    char *number = length < sizeof(digits) ? digits : talloc(length + 1);
+    memcpy(number, input + tokenStart, length);
+    number[length] = '\0';
+
     char *pointer;
-    Value *newToken = talloc(sizeof(Value));
+    Value *newToken;
     if (isDouble) {
+        newToken = gcValue();
         newToken->type = DOUBLE_TYPE;
         newToken->d = strtod(number, &pointer);
     } else {
-        newToken->type = INT_TYPE;
-        newToken->i = strtod(number, &pointer);
+        newToken = readInteger(number, length);
     }
 
-    fseek(stdin, -1L, SEEK_CUR);
     return newToken;
 }
 
-// open
-Value *openHelp() {
-  Value *newToken = talloc(sizeof(Value));
-  newToken->type = OPEN_TYPE;
-  
-  char *Open = talloc(sizeof(char) * 2);
-  Open [0] = '(';
-  Open [1] = '\0';
-
-  newToken->s = Open;
-
-  return newToken;
-}
-
-// close
-Value *closeHelp() {
-  Value *newToken = talloc(sizeof(Value));
-  newToken->type = CLOSE_TYPE;
-  
-  char *Close = talloc(sizeof(char) * 2);
-  Close [0] = ')';
-  Close [1] = '\0';
-
-  newToken->s = Close;
+// Parentheses, brackets, the dot of a dotted pair, the quote mark and the
+// #( that opens a vector.
+Value *punctuationHelp(valueType type, char *text) {
+  Value *newToken = gcValue();
+  newToken->type = type;
+  newToken->s = text;
+  newToken->length = strlen(text);
 
   return newToken;
 }
 
-// Read all of the input from stdin, and return a linked list consisting of the
-// tokens.
-Value *tokenize() {
-    char charRead = (char)fgetc(stdin);
-    Value *list = makeNull();
+// Reads the next token from stdin, or returns NULL at the end of the input.
+Value *nextToken() {
+    if (input == NULL) {
+      mapInput();
+    }
 
-    while (charRead != EOF) {
+    while (1) {
+      tokenStart = position;
+      int charRead = peekChar();
+      if (charRead == EOF) {
+        return NULL;
+      }
+      position++;
+      tokenLine = line;
       if (charRead == ';') {
-          commentCheck(charRead);
-      } else if (charRead == ' ' || charRead == '\n') {     // space / empty line check
-      } else if (isdigit(charRead) || charRead == '.' || 
+          commentCheck();
+      } else if (charRead == '\n') {                         // empty line check
+          line++;
+      } else if (charRead == ' ') {                          // space check
+      } else if (charRead == '.' && isDelimiter(peekChar())) {  // dot
+          return punctuationHelp(DOT_TYPE, ".");
+      } else if (charRead == '.' && !isdigit(peekChar())) {     // symbol such as ...
+          return symbolHelp();
+      } else if (isdigit(charRead) || charRead == '.' ||
                   charRead == '+' || charRead == '-') {     // int / double
-          list = cons(numHelp(charRead), list);
+          return numHelp(charRead);
       } else if (charRead == '"') {                         // string
-          list = cons(stringHelp(), list);
+          return stringHelp();
       } else if (charRead == '(') {                         // open
-          list = cons(openHelp(), list);
+          return punctuationHelp(OPEN_TYPE, "(");
       } else if (charRead == ')') {                         // close
-          list = cons(closeHelp(), list);
+          return punctuationHelp(CLOSE_TYPE, ")");
+      } else if (charRead == '[') {                         // open bracket
+          return punctuationHelp(OPENBRACKET_TYPE, "[");
+      } else if (charRead == ']') {                         // close bracket
+          return punctuationHelp(CLOSEBRACKET_TYPE, "]");
+      } else if (charRead == '\'') {                        // quote
+          return punctuationHelp(SINGLEQUOTE_TYPE, "'");
+      } else if (charRead == '#' && peekChar() == '(') {    // open vector
+          position++;
+          return punctuationHelp(OPENVECTOR_TYPE, "#(");
       } else if (charRead == '#') {                         // boolean
-          list = cons(boolHelp(), list);
+          return boolHelp();
       } else if (isalpha(charRead) || isSymbol(charRead)) {  // symbol
-        list = cons(symbolHelp(charRead), list);
+          return symbolHelp();
       } else {
         printf("Syntax error");
-        break;
+        inputEnded = 1;
+        position = inputLength;
+        return NULL;
       }
-      charRead = (char)fgetc(stdin);
     }
-    
-    Value *revList = reverse(list);
-    return revList;
+}
+
+// Read all of the input from stdin, and return a linked list consisting of the
+// tokens.
+Value *tokenize() {
+    Value *list = NULL_VALUE;
+    Value **tail = &list;
+    Value *token;
+    while ((token = nextToken()) != NULL) {
+      *tail = cons(token, NULL_VALUE);
+      tail = &(*tail)->c.cdr;
+    }
+    return list;
 }
 
 // Displays the contents of the linked list as tokens, with type information
 void displayTokens(Value *list) {
   while (!isNull(list) && !isNull(car(list))) {
-    switch (car(list)->type) {
+    switch (typeOf(car(list))) {
       case BOOL_TYPE:
-          if (car(list)->i == 0) {
+          if (!boolOf(car(list))) {
               printf("#f:boolean\n"); 
             } else {
               printf("#t:boolean\n");
             }
             break;
       case INT_TYPE:
-          printf("%i:integer\n", car(list)->i);
+      case BIGNUM_TYPE:
+          printInteger(car(list));
+          printf(":integer\n");
           break;
       case DOUBLE_TYPE:
           printf("%lf:double\n", car(list)->d);
           break;
       case STR_TYPE:
-          printf("%s:string\n", car(list)->s);
+          printf("\"%.*s\":string\n", car(list)->length, car(list)->s);
           break;
       case SYMBOL_TYPE:
           printf("%s:symbol\n", car(list)->s);
@@ -252,6 +351,14 @@ void displayTokens(Value *list) {
       case SINGLEQUOTE_TYPE:
         printf("%s:singlequote\n", car(list)->s);
         break; 
+      case OPENVECTOR_TYPE:
+        printf("%s:openvector\n", car(list)->s);
+        break;
+      case VECTOR_TYPE:
+      case F64VECTOR_TYPE:
+      case S64VECTOR_TYPE:
+      case HASHTABLE_TYPE:
+        break;
       case VOID_TYPE:
         break;
       case CLOSURE_TYPE:
@@ -260,6 +367,11 @@ void displayTokens(Value *list) {
       case PRIMITIVE_TYPE:
         printf("%s:primitive\n", car(list)->s);
         break;
+      case LOCAL_TYPE:
+        printf("%s:local\n", car(list)->ref.name->s);
+        break;
+      case CODE_TYPE:
+        break;
     }
     list = cdr(list);
   }
@@ -7,6 +7,13 @@
 // tokens.
 Value *tokenize();
 
+// Reads the next token from stdin, reading no further into the input than
+// it has to, or returns NULL at the end of the input.
+Value *nextToken();
+
+// The line, counting from 1, that the last token nextToken returned is on.
+extern int tokenLine;
+
 // Displays the contents of the linked list as tokens, with type information
 void displayTokens(Value *list);
 
@@ -1,6 +1,8 @@
 #ifndef _VALUE
 #define _VALUE
 
+#include <stdint.h>
+
 typedef enum {
     INT_TYPE, DOUBLE_TYPE, STR_TYPE, CONS_TYPE, NULL_TYPE, PTR_TYPE,
     OPEN_TYPE, CLOSE_TYPE, BOOL_TYPE, SYMBOL_TYPE,
@@ -13,15 +15,71 @@ typedef enum {
 
     // Type below is new for primitive portion
     PRIMITIVE_TYPE,
+
+    // Type below is new for lexical addressing
+    LOCAL_TYPE,
+
+    // Type below is new for the bytecode VM
+    CODE_TYPE,
+
+    // Type below is new for integers too large to be fixnums
+    BIGNUM_TYPE,
+
+    // Types below are new for vectors, and the #( token that starts one
+    VECTOR_TYPE, OPENVECTOR_TYPE,
+
+    // Types below are new for vectors of unboxed doubles and int64_ts
+    F64VECTOR_TYPE, S64VECTOR_TYPE,
+
+    // Type below is new for hash tables
+    HASHTABLE_TYPE,
 } valueType;
 
+// Special forms eval knows how to handle, plus the auxiliary keyword else.
+// Interned symbols with one of these names carry its tag, so eval can
+// dispatch with a switch instead of comparing names.
+typedef enum {
+    NO_SYNTAX, IF_SYNTAX, LET_SYNTAX, QUOTE_SYNTAX, DEFINE_SYNTAX,
+    LAMBDA_SYNTAX, LET_STAR_SYNTAX, LETREC_SYNTAX, COND_SYNTAX, SET_SYNTAX,
+    BEGIN_SYNTAX, AND_SYNTAX, OR_SYNTAX, ELSE_SYNTAX,
+} syntaxType;
+
 struct Value {
     valueType type;
     union {
         int i;
         double d;
-        char *s;
+        // Strings and symbols. Only symbols use syntax. length is the number
+        // of bytes in s. A string holds its text without the quotes, usually
+        // as a slice of the program text, and is not NUL-terminated; symbol
+        // names always are, and are stored just past the symbol itself.
+        struct {
+            char *s;
+            int length;
+            syntaxType syntax;
+        };
         void *p;
+        // An integer outside the fixnum range, as a sign and a magnitude of
+        // length 32-bit limbs, least significant first, stored just past the
+        // Value itself. See bignum.h.
+        struct Bignum {
+            int negative;
+            int length;
+        } big;
+        // A vector of length elements, stored just past the Value itself so
+        // that indexing is one load. See elementsOf. f64vectors and s64vectors
+        // keep their raw numbers there instead; see doublesOf and int64sOf.
+        struct Vector {
+            int length;
+        } vector;
+        // A hash table of count keys, kept in the vector entries. equal says
+        // whether keys are compared with equal? rather than eq?. See
+        // hashtable.h.
+        struct HashTable {
+            struct Value *entries;
+            int count;
+            int equal;
+        } table;
         struct ConsCell {
             struct Value *car;
             struct Value *cdr;
@@ -38,24 +96,125 @@ struct Value {
         } cl;
         
         // A primitive style function; just a pointer to it, with the right
-        // signature (pf = primitive function)
-        struct Value *(*pf)(struct Value *);
+        // signature (pf = primitive function), and where it is in the table of
+        // primitives, so that calls to it can be counted.
+        struct {
+            struct Value *(*pf)(struct Value *);
+            int primitive;
+        };
+
+        // A variable reference that the resolver has tied to a slot: the
+        // variable lives in slot `slot` of the frame `depth` levels up from
+        // the one the reference is evaluated in. The name is kept for error
+        // messages.
+        struct LocalRef {
+            int depth;
+            int slot;
+            struct Value *name;
+        } ref;
+
+        // Compiled bytecode. A closure made by the VM keeps one of these as
+        // its functionCode instead of a parse tree.
+        struct Code *code;
     };
 };
 
 typedef struct Value Value;
 
 
-// A frame is a linked list of bindings, and a pointer to another frame.  A
-// binding is a variable name (represented as a string), and a pointer to the
-// Value it is bound to. 
+// A frame holds the variables bound by one lambda application or let form in
+// an array of slots, numbered by the resolver in binding order, and a pointer
+// to the enclosing frame. The global frame has no slots; globals live in a
+// hash table in interpreter.c instead, since top-level defines can add to
+// them at any time.
 struct Frame {
-    struct Value *bindings;
     struct Frame *parent;
+    int size;
+    struct Value *slots[];
 };
 
 typedef struct Frame Frame;
 
+// Bytecode for one lambda body or top-level form, as produced by the
+// compiler. The constants pool comes first and the instructions follow it, so
+// the whole thing is a single heap object.
+struct Code {
+    int arity;
+    int line;  // of its lambda, when profiling; see profile.h
+    int constantCount;
+    int length;
+    struct Value *constants[];
+};
+
+typedef struct Code Code;
+
+// Integers, booleans, the empty list and void are never allocated: they are
+// encoded in the Value pointer itself. Heap objects are 8-byte aligned, so a
+// pointer with either of its low two bits set is an immediate. A set low bit
+// marks a fixnum, with the integer in the remaining bits; the other
+// immediates are the four constants below. Anything that may be an immediate
+// must go through typeOf and the accessors here rather than ->type and ->i.
+#define FALSE_VALUE ((Value *) 0x02)
+#define TRUE_VALUE ((Value *) 0x0a)
+#define NULL_VALUE ((Value *) 0x12)
+#define VOID_VALUE ((Value *) 0x1a)
+
+static inline int isImmediate(Value *value) {
+    return ((uintptr_t) value & 3) != 0;
+}
+
+static inline int isFixnum(Value *value) {
+    return ((uintptr_t) value & 1) != 0;
+}
+
+static inline valueType typeOf(Value *value) {
+    if (isFixnum(value)) {
+        return INT_TYPE;
+    } else if (!isImmediate(value)) {
+        return value->type;
+    } else if (value == NULL_VALUE) {
+        return NULL_TYPE;
+    } else if (value == VOID_VALUE) {
+        return VOID_TYPE;
+    }
+    return BOOL_TYPE;
+}
+
+// The integers a fixnum can hold: one bit of the pointer goes on the tag.
+#define FIXNUM_MAX (INTPTR_MAX >> 1)
+#define FIXNUM_MIN (INTPTR_MIN >> 1)
+
+static inline Value *makeInt(intptr_t i) {
+    return (Value *) (((uintptr_t) i << 1) | 1);
+}
+
+static inline intptr_t intOf(Value *value) {
+    return (intptr_t) value >> 1;
+}
+
+static inline Value *makeBool(int b) {
+    return b ? TRUE_VALUE : FALSE_VALUE;
+}
+
+// For a BOOL_TYPE value, 1 for #t and 0 for #f.
+static inline int boolOf(Value *value) {
+    return value == TRUE_VALUE;
+}
+
+// The elements of a VECTOR_TYPE value.
+static inline Value **elementsOf(Value *vector) {
+    return (Value **) (vector + 1);
+}
+
+// The elements of an F64VECTOR_TYPE or an S64VECTOR_TYPE value.
+static inline double *doublesOf(Value *vector) {
+    return (double *) (vector + 1);
+}
+
+static inline int64_t *int64sOf(Value *vector) {
+    return (int64_t *) (vector + 1);
+}
+
 
 
 
@@ -0,0 +1,46 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include "vector.h"
+#include "value.h"
+#include "linkedlist.h"
+#include "talloc.h"
+#include "gc.h"
+
+Value *makeVector(int length, Value *fill) {
+  Value *vector = gcAlloc(sizeof(Value) + sizeof(Value *) * length, GC_VALUE);
+  vector->type = VECTOR_TYPE;
+  vector->vector.length = length;
+  Value **elements = elementsOf(vector);
+  for (int i = 0; i < length; i++) {
+    elements[i] = fill;
+  }
+  return vector;
+}
+
+Value *listToVector(Value *list) {
+  int length = 0;
+  Value *tail = list;
+  while (typeOf(tail) == CONS_TYPE) {
+    length++;
+    tail = cdr(tail);
+  }
+  if (tail != NULL_VALUE) {
+    return NULL;
+  }
+
+  Value *vector = makeVector(length, NULL_VALUE);
+  Value **elements = elementsOf(vector);
+  for (int i = 0; i < length; i++) {
+    elements[i] = car(list);
+    list = cdr(list);
+  }
+  return vector;
+}
+
+Value *vectorToList(Value *vector) {
+  Value *list = NULL_VALUE;
+  for (int i = vector->vector.length - 1; i >= 0; i--) {
+    list = cons(elementsOf(vector)[i], list);
+  }
+  return list;
+}
@@ -0,0 +1,16 @@
+#include "value.h"
+
+#ifndef _VECTOR
+#define _VECTOR
+
+// Allocates a vector of length elements, each set to fill.
+Value *makeVector(int length, Value *fill);
+
+// Returns a new vector of the elements of a proper list, or NULL if list is
+// not one.
+Value *listToVector(Value *list);
+
+// Returns a new list of the elements of a vector.
+Value *vectorToList(Value *vector);
+
+#endif
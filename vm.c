@@ -0,0 +1,336 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "vm.h"
+#include "value.h"
+#include "linkedlist.h"
+#include "talloc.h"
+#include "gc.h"
+#include "interpreter.h"
+#include "stats.h"
+#include "profile.h"
+
+// What a non-tail call saves so the callee can return to it.
+typedef struct CallRecord {
+  Value *code;
+  Frame *frame;
+  int *ip;
+} CallRecord;
+
+// The operand stack and the call stack. Both are shared by every execute, and
+// are traced by traceVm since they change far too often to protect entry by
+// entry.
+Value **vmStack;
+int vmTop;
+int vmCapacity;
+
+CallRecord *vmCalls;
+int vmCallTop;
+int vmCallCapacity;
+
+// Doubles a stack allocated with talloc, abandoning the old one to the arena.
+void *growStack(void *stack, int top, int *capacity, size_t size) {
+  int newCapacity = *capacity == 0 ? 1024 : *capacity * 2;
+  void *newStack = talloc(size * newCapacity);
+  if (top > 0) {
+    memcpy(newStack, stack, size * top);
+  }
+  *capacity = newCapacity;
+  return newStack;
+}
+
+void traceVm(void (*visit)(void **)) {
+  for (int i = 0; i < vmTop; i++) {
+    visit((void **) &vmStack[i]);
+  }
+  for (int i = 0; i < vmCallTop; i++) {
+    visit((void **) &vmCalls[i].code);
+    visit((void **) &vmCalls[i].frame);
+  }
+}
+
+int *instructionsOf(Code *code) {
+  return (int *) (code->constants + code->constantCount);
+}
+
+Frame *enclosingFrame(int depth, Frame *frame) {
+  while (depth > 0) {
+    frame = frame->parent;
+    depth--;
+  }
+  return frame;
+}
+
+Value *checkBound(Value *value) {
+  if (value == NULL) {
+    evaluationError("execute: variable used before it is bound");
+  }
+  return value;
+}
+
+#define PUSH(value) do { \
+    if (vmTop == vmCapacity) { \
+      vmStack = growStack(vmStack, vmTop, &vmCapacity, sizeof(Value *)); \
+    } \
+    vmStack[vmTop++] = (value); \
+  } while (0)
+
+#define POP() (vmStack[--vmTop])
+
+// Dispatch jumps straight from one instruction's code to the next through a
+// table of label addresses where the compiler supports it, and goes round a
+// switch otherwise.
+#if defined(__GNUC__) && !defined(VM_NO_COMPUTED_GOTO)
+#define VM_COMPUTED_GOTO
+#endif
+
+#ifdef VM_COMPUTED_GOTO
+#define TARGET(op) case op: label_##op
+#define DISPATCH() goto *targets[*ip++]
+#else
+#define TARGET(op) case op
+#define DISPATCH() goto dispatch
+#endif
+
+Value *execute(Value *code, Frame *frame) {
+  if (vmStack == NULL) {
+    vmStack = growStack(vmStack, 0, &vmCapacity, sizeof(Value *));
+    gcAddRootTracer(traceVm);
+  }
+  gcProtect(code);
+  gcProtect(frame);
+
+  // Returning from this call record depth means returning from execute.
+  int entry = vmCallTop;
+  int profileBase = profileDepth;
+  int *ip = instructionsOf(code->code);
+  Value **constants = code->code->constants;
+  Value *result;
+
+#ifdef VM_COMPUTED_GOTO
+  static void *targets[] = {
+    [OP_CONST] = &&label_OP_CONST,
+    [OP_LOCAL] = &&label_OP_LOCAL,
+    [OP_FREE] = &&label_OP_FREE,
+    [OP_GLOBAL] = &&label_OP_GLOBAL,
+    [OP_SET_LOCAL] = &&label_OP_SET_LOCAL,
+    [OP_SET_FREE] = &&label_OP_SET_FREE,
+    [OP_SET_GLOBAL] = &&label_OP_SET_GLOBAL,
+    [OP_DEFINE] = &&label_OP_DEFINE,
+    [OP_POP] = &&label_OP_POP,
+    [OP_JUMP] = &&label_OP_JUMP,
+    [OP_JUMP_IF_FALSE] = &&label_OP_JUMP_IF_FALSE,
+    [OP_AND_JUMP] = &&label_OP_AND_JUMP,
+    [OP_OR_JUMP] = &&label_OP_OR_JUMP,
+    [OP_CLOSURE] = &&label_OP_CLOSURE,
+    [OP_ENTER] = &&label_OP_ENTER,
+    [OP_ENTER_EMPTY] = &&label_OP_ENTER_EMPTY,
+    [OP_FILL] = &&label_OP_FILL,
+    [OP_LEAVE] = &&label_OP_LEAVE,
+    [OP_CALL] = &&label_OP_CALL,
+    [OP_TAIL_CALL] = &&label_OP_TAIL_CALL,
+    [OP_RETURN] = &&label_OP_RETURN,
+    [OP_ERROR] = &&label_OP_ERROR,
+  };
+  DISPATCH();
+#else
+dispatch:
+#endif
+  switch (*ip++) {
+    TARGET(OP_CONST): {
+      PUSH(constants[*ip++]);
+      DISPATCH();
+    }
+    TARGET(OP_LOCAL): {
+      stats.localLookups++;
+      PUSH(checkBound(frame->slots[*ip++]));
+      DISPATCH();
+    }
+    TARGET(OP_FREE): {
+      stats.localLookups++;
+      stats.framesWalked += ip[0];
+      Frame *outer = enclosingFrame(ip[0], frame);
+      PUSH(checkBound(outer->slots[ip[1]]));
+      ip += 2;
+      DISPATCH();
+    }
+    TARGET(OP_GLOBAL): {
+      PUSH(lookUpSymbol(constants[*ip++]));
+      DISPATCH();
+    }
+    TARGET(OP_SET_LOCAL): {
+      frame->slots[*ip++] = POP();
+      gcWriteBarrier(frame);
+      DISPATCH();
+    }
+    TARGET(OP_SET_FREE): {
+      Frame *outer = enclosingFrame(ip[0], frame);
+      outer->slots[ip[1]] = POP();
+      gcWriteBarrier(outer);
+      ip += 2;
+      DISPATCH();
+    }
+    TARGET(OP_SET_GLOBAL): {
+      if (!setBinding(constants[*ip++], POP(), frame)) {
+        evaluationError("no binding to modify in set!");
+      }
+      DISPATCH();
+    }
+    TARGET(OP_DEFINE): {
+      defineGlobal(constants[*ip++], POP());
+      DISPATCH();
+    }
+    TARGET(OP_POP): {
+      vmTop--;
+      DISPATCH();
+    }
+    TARGET(OP_JUMP): {
+      ip = instructionsOf(code->code) + *ip;
+      DISPATCH();
+    }
+    TARGET(OP_JUMP_IF_FALSE): {
+      Value *test = POP();
+      if (typeOf(test) != BOOL_TYPE) {
+        evaluationError("execute: condition is not a boolean");
+      }
+      ip = boolOf(test) ? ip + 1 : instructionsOf(code->code) + *ip;
+      DISPATCH();
+    }
+    TARGET(OP_AND_JUMP): {
+      Value *test = vmStack[vmTop - 1];
+      if (test == FALSE_VALUE) {
+        ip = instructionsOf(code->code) + *ip;
+      } else {
+        vmTop--;
+        ip++;
+      }
+      DISPATCH();
+    }
+    TARGET(OP_OR_JUMP): {
+      Value *test = vmStack[vmTop - 1];
+      if (test == FALSE_VALUE) {
+        vmTop--;
+        ip++;
+      } else {
+        ip = instructionsOf(code->code) + *ip;
+      }
+      DISPATCH();
+    }
+    TARGET(OP_CLOSURE): {
+      Value *closure = gcValue();
+      closure->type = CLOSURE_TYPE;
+      closure->cl.paramNames = NULL;
+      closure->cl.functionCode = constants[*ip++];
+      closure->cl.frame = frame;
+      if (profiling) {
+        profileNoteCode(closure->cl.functionCode, closure->cl.functionCode->code->line);
+      }
+      PUSH(closure);
+      DISPATCH();
+    }
+    TARGET(OP_ENTER): {
+      int count = *ip++;
+      Frame *newFrame = gcFrame(count);
+      newFrame->parent = frame;
+      vmTop -= count;
+      memcpy(newFrame->slots, vmStack + vmTop, sizeof(Value *) * count);
+      frame = newFrame;
+      DISPATCH();
+    }
+    TARGET(OP_ENTER_EMPTY): {
+      Frame *newFrame = gcFrame(*ip++);
+      newFrame->parent = frame;
+      frame = newFrame;
+      DISPATCH();
+    }
+    TARGET(OP_FILL): {
+      int count = *ip++;
+      vmTop -= count;
+      memcpy(frame->slots, vmStack + vmTop, sizeof(Value *) * count);
+      gcWriteBarrier(frame);
+      DISPATCH();
+    }
+    TARGET(OP_LEAVE): {
+      frame = enclosingFrame(*ip++, frame);
+      DISPATCH();
+    }
+    TARGET(OP_CALL):
+    TARGET(OP_TAIL_CALL): {
+      int tail = ip[-1] == OP_TAIL_CALL;
+      int count = *ip++;
+      Value *function = POP();
+
+      if (typeOf(function) == PRIMITIVE_TYPE) {
+        // Primitives take their arguments as a list, last argument first.
+        Value *args = NULL_VALUE;
+        for (int i = vmTop - count; i < vmTop; i++) {
+          args = cons(vmStack[i], args);
+        }
+        vmTop -= count;
+        stats.primitiveCalls[function->primitive]++;
+        PUSH((function->pf)(args));
+        if (tail) {
+          goto doReturn;
+        }
+        DISPATCH();
+      } else if (typeOf(function) != CLOSURE_TYPE ||
+                 typeOf(function->cl.functionCode) != CODE_TYPE) {
+        evaluationError("apply: invalid function");
+      }
+
+      Value *callee = function->cl.functionCode;
+      if (count != callee->code->arity) {
+        evaluationError("apply: invalid");
+      }
+      stats.closureApplications++;
+      if (profiling) {
+        profileEnter(function->cl.functionCode, profileBase, tail);
+      }
+      Frame *newFrame = gcFrame(count);
+      newFrame->parent = function->cl.frame;
+      vmTop -= count;
+      memcpy(newFrame->slots, vmStack + vmTop, sizeof(Value *) * count);
+
+      if (!tail) {
+        if (vmCallTop == vmCallCapacity) {
+          vmCalls = growStack(vmCalls, vmCallTop, &vmCallCapacity,
+                              sizeof(CallRecord));
+        }
+        vmCalls[vmCallTop].code = code;
+        vmCalls[vmCallTop].frame = frame;
+        vmCalls[vmCallTop].ip = ip;
+        vmCallTop++;
+      }
+      code = callee;
+      frame = newFrame;
+      ip = instructionsOf(code->code);
+      constants = code->code->constants;
+      gcSafePoint();
+      DISPATCH();
+    }
+    TARGET(OP_RETURN): {
+    doReturn:
+      if (vmCallTop == entry) {
+        result = POP();
+        profileDepth = profileBase;
+        gcUnprotect(2);
+        return result;
+      }
+      if (profiling) {
+        profileDepth--;
+      }
+      vmCallTop--;
+      code = vmCalls[vmCallTop].code;
+      frame = vmCalls[vmCallTop].frame;
+      ip = vmCalls[vmCallTop].ip;
+      constants = code->code->constants;
+      DISPATCH();
+    }
+    TARGET(OP_ERROR): {
+      evaluationError(constants[*ip++]->s);
+      DISPATCH();
+    }
+  }
+  evaluationError("execute: invalid instruction");
+  return NULL;
+}
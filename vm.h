@@ -0,0 +1,45 @@
+#include "value.h"
+
+#ifndef _VM
+#define _VM
+
+// The instruction set. Each instruction is an opcode followed by its
+// operands, all stored as ints. Constant operands index the constants pool of
+// the Code being run.
+typedef enum {
+    OP_CONST,           // k: push constant k
+    OP_LOCAL,           // slot: push a slot of the current frame
+    OP_FREE,            // depth slot: push a slot of an enclosing frame
+    OP_GLOBAL,          // k: push the global value of symbol constant k
+    OP_SET_LOCAL,       // slot: pop into a slot of the current frame
+    OP_SET_FREE,        // depth slot: pop into a slot of an enclosing frame
+    OP_SET_GLOBAL,      // k: pop into the global binding of symbol k
+    OP_DEFINE,          // k: pop and bind symbol constant k in the global frame
+    OP_POP,             // discard the top of the stack
+    OP_JUMP,            // target: continue at instruction target
+    OP_JUMP_IF_FALSE,   // target: pop a boolean, and jump if it is #f
+    OP_AND_JUMP,        // target: jump if the top is #f, else pop it
+    OP_OR_JUMP,         // target: jump unless the top is #f, else pop it
+    OP_CLOSURE,         // k: push a closure over the current frame whose
+                        //    body is CODE_TYPE constant k
+    OP_ENTER,           // count: pop count values into the slots of a new
+                        //    frame, which becomes the current one
+    OP_ENTER_EMPTY,     // count: make a new current frame of count empty slots
+    OP_FILL,            // count: pop count values into the current frame
+    OP_LEAVE,           // count: go back up count frames
+    OP_CALL,            // count: pop a procedure, then count arguments (the
+                        //    last one on top), and push what it returns
+    OP_TAIL_CALL,       // count: like OP_CALL, but return its result
+    OP_RETURN,          // return the top of the stack to the caller
+    OP_ERROR,           // k: evaluation error with string constant k
+} opcode;
+
+// Returns the instructions of code, which follow its constants.
+int *instructionsOf(Code *code);
+
+// Runs compiled code to completion in the given frame and returns its value.
+// Code is assumed not to move, so it must be in the old space: collect the
+// nursery after compiling and before executing.
+Value *execute(Value *code, Frame *frame);
+
+#endif